@@ -0,0 +1,194 @@
+#include "bench.h"
+#include "board.h"
+#include "int64.h"
+#include "search.h"
+#include "step.h"
+#include "textfile.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string.h>
+#include <string>
+
+using namespace std;
+
+//the positions of the suite, in the position file format. The first three
+//are the test positions that come with the bot.
+static const char* benchPositions[BENCH_NUM_POSITIONS] =
+{
+    //test1
+    "10g\n"
+    " +-----------------+\n"
+    "8| r r r d d r r r |\n"
+    "7|   r c     m c r |\n"
+    "6| H h         h R |\n"
+    "5|       E         |\n"
+    "4|         e       |\n"
+    "3|       C H   M   |\n"
+    "2| R   D       D   |\n"
+    "1| R R R   C R R R |\n"
+    " +-----------------+\n"
+    "   a b c d e d g h\n",
+
+    //test2
+    "15s\n"
+    " +-----------------+\n"
+    "8| r r r   d r r r |\n"
+    "7| r   c     d M r |\n"
+    "6|   h m       e R |\n"
+    "5|           E h   |\n"
+    "4|                 |\n"
+    "3|   H   C H   D   |\n"
+    "2| R   D     R     |\n"
+    "1| R R R   C   R R |\n"
+    " +-----------------+\n"
+    "   a b c d e d g h\n",
+
+    //test3
+    "22w\n"
+    " +-----------------+\n"
+    "8| r r r   d r r r |\n"
+    "7| r         E d r |\n"
+    "6|   h     c     R |\n"
+    "5|           e D m |\n"
+    "4|   H             |\n"
+    "3|       C       H |\n"
+    "2| R   D   C R     |\n"
+    "1| R R R       R R |\n"
+    " +-----------------+\n"
+    "   a b c d e d g h\n",
+
+    //opening
+    "2g\n"
+    " +-----------------+\n"
+    "8| r r r d d r r r |\n"
+    "7| r h c m e c h r |\n"
+    "6|                 |\n"
+    "5|                 |\n"
+    "4|                 |\n"
+    "3|                 |\n"
+    "2| R H C M E C H R |\n"
+    "1| R R R D D R R R |\n"
+    " +-----------------+\n"
+    "   a b c d e f g h\n",
+
+    //early silver move
+    "2s\n"
+    " +-----------------+\n"
+    "8| r r r d d r r r |\n"
+    "7| r h c m e c h r |\n"
+    "6|                 |\n"
+    "5|         E       |\n"
+    "4|                 |\n"
+    "3|       M         |\n"
+    "2| R H C     C H R |\n"
+    "1| R R R D D R R R |\n"
+    " +-----------------+\n"
+    "   a b c d e f g h\n",
+
+    //early gold move
+    "3g\n"
+    " +-----------------+\n"
+    "8| r r r d d r r r |\n"
+    "7| r h c     c h r |\n"
+    "6|       m         |\n"
+    "5|       e E       |\n"
+    "4|                 |\n"
+    "3|       M         |\n"
+    "2| R H C     C H R |\n"
+    "1| R R R D D R R R |\n"
+    " +-----------------+\n"
+    "   a b c d e f g h\n",
+
+    //test1 after a step
+    "10g Ed5n\n"
+    " +-----------------+\n"
+    "8| r r r d d r r r |\n"
+    "7|   r c     m c r |\n"
+    "6| H h         h R |\n"
+    "5|       E         |\n"
+    "4|         e       |\n"
+    "3|       C H   M   |\n"
+    "2| R   D       D   |\n"
+    "1| R R R   C R R R |\n"
+    " +-----------------+\n"
+    "   a b c d e d g h\n"
+};
+
+//names of the positions, for the report
+static const char* benchNames[BENCH_NUM_POSITIONS] =
+{
+    "test1",
+    "test2",
+    "test3",
+    "opening",
+    "early silver move",
+    "early gold move",
+    "test1 after a step"
+};
+
+//////////////////////////////////////////////////////////////////////////////
+//Loads the position of the suite with that index onto the board
+//////////////////////////////////////////////////////////////////////////////
+void loadBenchPosition(Board& board, int index)
+{
+    const char* text = benchPositions[index];
+    board.loadPositionText(TextRange(text, text + strlen(text)));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Searches every position of the suite to the depth given with the eval
+//weights given and fresh tables, and writes the nodes, time and best move
+//of each and then the totals to out. The signature is a mix of the node
+//counts and scores of all positions, so it stays the same unless the
+//search behaves differently. Returns the signature.
+//////////////////////////////////////////////////////////////////////////////
+Int64 runBench(int depth, string evalWeightFile, ostream& out)
+{
+    Board board;
+    board.genRandomHashes();
+
+    Search search(BENCH_HASH_BYTES);
+    search.eval.loadWeights(evalWeightFile);
+
+    //the search doesn't need a log
+    ostream noLog(0);
+
+    Int64 totalNodes = 0;
+    double totalSeconds = 0;
+    Int64 signature = 0;
+
+    out << "Searching " << BENCH_NUM_POSITIONS << " positions to depth "
+        << depth << "\n";
+    for (int i = 0; i < BENCH_NUM_POSITIONS; i++)
+    {
+        loadBenchPosition(board, i);
+        search.gameHistTable.reset();
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        StepCombo bestMove = search.iterativeDeepen(board, depth, noLog);
+        double seconds = chrono::duration<double>(
+                         chrono::steady_clock::now() - start).count();
+
+        totalNodes += search.numTotalNodes;
+        totalSeconds += seconds;
+        signature = signature * 1000003 + search.numTotalNodes;
+        signature = signature * 1000003 + (unsigned short)search.rootScore;
+
+        out << setw(20) << left << benchNames[i] << right
+            << setw(7) << search.rootScore
+            << setw(12) << search.numTotalNodes
+            << setw(9) << (Int64)(seconds * 1000) << " ms  "
+            << bestMove.toString() << "\n";
+    }
+
+    out << "Total nodes " << totalNodes << "\n"
+        << "Total time " << (Int64)(totalSeconds * 1000) << " ms\n"
+        << "Nodes/sec " << (Int64)(totalSeconds > 0 ? totalNodes
+                                                      / totalSeconds : 0)
+        << "\n"
+        << "Signature " << hex << setw(16) << setfill('0') << signature
+        << dec << setfill(' ') << endl;
+
+    return signature;
+}
@@ -0,0 +1,26 @@
+#ifndef __JR_BENCH_H__
+#define __JR_BENCH_H__
+
+//Search benchmark over a fixed suite of positions
+
+#include "board.h"
+#include "int64.h"
+#include <iostream>
+#include <string>
+
+//number of positions in the suite
+#define BENCH_NUM_POSITIONS 7
+
+//depth every position of the suite is searched to by default
+#define BENCH_DEPTH 10
+
+//size of all the hash tables of the benchmark search, fixed so the node
+//counts only change when the search does
+#define BENCH_HASH_BYTES (64 * 1024 * 1024)
+
+using namespace std;
+
+void loadBenchPosition(Board& board, int index);
+Int64 runBench(int depth, string evalWeightFile, ostream& out);
+
+#endif
@@ -5,6 +5,8 @@
 #include "int64.h"
 #include "step.h"
 #include "hash.h"
+#include "textfile.h"
+#include <ctype.h>
 #include <fstream>
 #include <iostream>
 #include <string.h>
@@ -60,10 +62,9 @@ void Board :: reset()
 //////////////////////////////////////////////////////////////////////////////
 void Board :: loadPositionFile(string filename)
 {
+    TextFile in;
 
-    ifstream in(filename.c_str());
-
-    if (!in.is_open())
+    if (!in.open(filename))
     {
         Error error;
         error << "From Board :: loadPositionFile(string)\n"
@@ -72,34 +73,42 @@ void Board :: loadPositionFile(string filename)
         throw error;
     }
 
-    string line;
-    stringstream lineStream;
-    string word;
+    loadPositionText(in.getText());
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Load a position in the position file format from text in memory onto this
+//board object. Throws an Error object if the text has an invalid syntax.
+//////////////////////////////////////////////////////////////////////////////
+void Board :: loadPositionText(TextRange text)
+{
+    TextRange line;
+    TextRange word;
 
     //read the first line, which should contain the turn number, the color
     //to move, and steps made this turn if any
-    getline(in,line);
-    lineStream.str(line);
-    lineStream >> word;
+    text.nextLine(line);
+    line.nextWord(word);
     
-    stringstream wordStream(word);
-    if (!isdigit(word[0]))
+    if (word.length() == 0 || !isdigit(*word.begin))
     {
         Error error;
-        error << "From Board :: loadPositionFile(string)\n"
+        error << "From Board :: loadPositionText(TextRange)\n"
               << "Expected turn number as first part in first line\n"
-              << "Got: " << word << '\n';
+              << "Got: " << word.toString() << '\n';
         throw error;
     }
-    wordStream >> turnNumber;
 
-    unsigned char colorChar;
-    wordStream >> colorChar;
+    turnNumber = 0;
+    while (word.begin < word.end && isdigit(*word.begin))
+        turnNumber = turnNumber * 10 + (*word.begin++ - '0');
+
+    unsigned char colorChar = word.at(0);
     if (colorChar != 'w' && colorChar != 'b' && colorChar != 's' 
      && colorChar != 'g')
     {
         Error error;
-        error << "From Board :: loadPositionFile(string)\n"
+        error << "From Board :: loadPositionText(TextRange)\n"
               << "Expected color as second part in first line\n"
               << "Got: " << colorChar << '\n';
         throw error;
@@ -112,13 +121,10 @@ void Board :: loadPositionFile(string filename)
 
     //read off the steps on the first line if any    
     StepCombo initSteps;
-    string rest;
-    getline(lineStream, rest);
-    initSteps.fromString(rest);
-
+    initSteps.fromChars(line.begin, line.end);
 
     //skip the next line
-    getline(in,line);
+    text.nextLine(line);
     
     //zero out the bitboards before reading the pieces
     for (int i = 0; i < MAX_COLORS; i++)
@@ -135,13 +141,14 @@ void Board :: loadPositionFile(string filename)
     //read the next 8 lines to read the board
     for (int i = 0; i < 8; i++)
     {
-        getline(in,line);
+        if (!text.nextLine(line))
+            line = TextRange();
         
         for (int j = 0; j < 8; j++)
         {
-            char pieceChar = line[3 + 2 * j]; //skip first 3 characters
-                                              //and then read every other
-                                              //character afterward
+            char pieceChar = line.at(3 + 2 * j); //skip first 3 characters
+                                                 //and then read every other
+                                                 //character afterward
 
             //check for traps or empty squares
             if (pieceChar == 'X' || pieceChar == 'x' || pieceChar == ' ')
@@ -160,8 +167,6 @@ void Board :: loadPositionFile(string filename)
     //attempt to play the stored steps
     stepsLeft = 4;
     playCombo(initSteps);
-
-    in.close();
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -189,6 +194,111 @@ void Board :: genRandomHashes()
     }
 }
 
+//////////////////////////////////////////////////////////////////////////////
+//Writes the position, side to move, steps left and turn number to the
+//packed board given. Throws an Error if there are more than 32 pieces,
+//which can't happen in a real game.
+//////////////////////////////////////////////////////////////////////////////
+void Board :: encode(PackedBoard& packed)
+{
+    memset(&packed, 0, sizeof(packed));
+    packed.occupied = getAllPieces();
+    packed.turnNumber = turnNumber;
+    packed.sideToMove = sideToMove;
+    packed.stepsLeft = stepsLeft;
+
+    if (numBits(packed.occupied) > 32)
+    {
+        Error error;
+        error << "From Board :: encode\n"
+              << "Too many pieces to pack: "
+              << numBits(packed.occupied) << "\n";
+        throw error;
+    }
+
+    Int64 b = packed.occupied;
+    int index;
+    int num = 0;
+    while ((index = bitScanForward(b)) != NO_BIT_FOUND)
+    {
+        b ^= Int64FromIndex(index);
+        packed.pieces[num / 2] |= getPieceAt(index) << (num % 2 * 4);
+        num++;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Sets the board to a packed board written by encode(), and works out the
+//hashes with this board's hash parts. Throws an Error if the packed board
+//isn't a valid one.
+//////////////////////////////////////////////////////////////////////////////
+void Board :: decode(const PackedBoard& packed)
+{
+    if (packed.sideToMove >= MAX_COLORS || packed.stepsLeft > 4 ||
+        numBits(packed.occupied) > 32)
+    {
+        Error error;
+        error << "From Board :: decode\n"
+              << "Invalid packed board\n";
+        throw error;
+    }
+
+    reset();
+
+    Int64 b = packed.occupied;
+    int index;
+    int num = 0;
+    while ((index = bitScanForward(b)) != NO_BIT_FOUND)
+    {
+        b ^= Int64FromIndex(index);
+        unsigned char piece = (packed.pieces[num / 2] >> (num % 2 * 4)) & 0xF;
+        if (typeOfPiece(piece) >= MAX_TYPES)
+        {
+            Error error;
+            error << "From Board :: decode\n"
+                  << "Invalid piece in packed board: "
+                  << (int)piece << "\n";
+            throw error;
+        }
+
+        writePieceOnBoard(index, colorOfPiece(piece), typeOfPiece(piece));
+        num++;
+    }
+
+    turnNumber = packed.turnNumber;
+    sideToMove = packed.sideToMove;
+    stepsLeft = packed.stepsLeft;
+
+    hash ^= hashTurnParts[sideToMove];
+    hash ^= hashStepsLeftParts[stepsLeft];
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Returns a mix of all the random hash parts, to check that data saved with
+//hashes from another run was made with the same hash parts
+//////////////////////////////////////////////////////////////////////////////
+Int64 Board :: getHashPartsCheck()
+{
+    Int64 check = 0;
+    for (int color = 0; color < MAX_COLORS; color++)
+    {
+        for (int type = 0; type < MAX_TYPES; type++)
+        {
+            for (int square = 0; square < NUM_SQUARES; square++)
+            {
+                check = check * 31 + hashPieceParts[color][type][square];
+            }
+        }
+
+        check = check * 31 + hashTurnParts[color];
+    }
+
+    for (int i = 0; i < 5; i++)
+        check = check * 31 + hashStepsLeftParts[i];
+
+    return check;
+}
+
 //////////////////////////////////////////////////////////////////////////////
 //Checks if a piece on the square specified by index is frozen. Returns
 //true if the piece is placed on that square would be frozen (that piece need 
@@ -447,6 +557,18 @@ void Board :: changeTurn()
     sideToMove = oppColorOf(sideToMove);
 }
     
+//////////////////////////////////////////////////////////////////////////////
+//Returns the hash the board would have after changeTurn(), without changing
+//the turn
+//////////////////////////////////////////////////////////////////////////////
+Int64 Board :: getChangedTurnHash()
+{
+    return hash ^ hashTurnParts[sideToMove]
+                ^ hashTurnParts[oppColorOf(sideToMove)]
+                ^ hashStepsLeftParts[stepsLeft]
+                ^ hashStepsLeftParts[4];
+}
+
 //////////////////////////////////////////////////////////////////////////////
 //Undoes a turn change. Note that the old number of steps is needed to 
 //undo the change, as the player may have passed with steps left.
@@ -1385,6 +1507,70 @@ unsigned int Board :: genMovesToSquare(vector<StepCombo>& combos,
     return num;
 }
     
+//////////////////////////////////////////////////////////////////////////////
+//Generates only the tactical moves from the current board state, that is the
+//moves that capture an enemy piece or get a friendly rabbit onto the goal
+//row. Used to extend the search past the horizon. Returns the number of
+//moves generated and appends all moves generated to the end of the list
+//given.
+//////////////////////////////////////////////////////////////////////////////
+unsigned int Board :: genTacticalMoves(vector<StepCombo>& combos)
+{
+    if (stepsLeft < 1)
+        return 0;
+
+    Int64 goalRow  = sideToMove == GOLD ? getRow(0) : getRow(7);
+    Int64 nearGoal = sideToMove == GOLD ? getRow(1) : getRow(6);
+
+    //Quickly check if there can be any tactical moves at all. Enemy pieces
+    //can only be captured if they are on or next to a trap, and a rabbit
+    //can only reach the goal in one step from the row before it. This
+    //avoids generating all the moves on most quiet positions.
+    Int64 enemies = getAllPiecesOfColor(oppColorOf(sideToMove));
+    bool canCapture = stepsLeft > 1 && 
+                      (enemies & (getTraps() | getTrapNeighbors()));
+    bool canGoal    = pieces[sideToMove][RABBIT] & nearGoal;
+
+    if (!canCapture && !canGoal)
+        return 0;
+
+    //Generate all the moves, then keep only the tactical ones
+    unsigned int first = combos.size();
+    genMoves(combos);
+
+    unsigned int num = 0;
+    for (unsigned int i = first; i < combos.size(); ++i)
+    {
+        bool tactical = false;
+        for (int j = 0; j < combos[i].numSteps; ++j)
+        {
+            Step& step = combos[i].steps[j];
+            unsigned char piece = step.getPiece();
+            
+            if (step.isCapture())
+            {
+                if (colorOfPiece(piece) != sideToMove)
+                    tactical = true;
+            }
+            else if (typeOfPiece(piece) == RABBIT && 
+                     colorOfPiece(piece) == sideToMove &&
+                     (goalRow & Int64FromIndex(step.getTo())))
+            {
+                tactical = true;
+            }
+        }
+
+        if (tactical)
+        {
+            combos[first + num] = combos[i];
+            ++num;
+        }
+    }
+
+    combos.resize(first + num);
+    return num;
+}
+
 //////////////////////////////////////////////////////////////////////////////
 //Attempt to generate the 1-step move using the from and to square specified. 
 //If it is a legal move, then it is written onto the combo given and true is
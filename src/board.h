@@ -7,11 +7,28 @@
 #include "piece.h"
 #include "square.h"
 #include "hash.h"
+#include "textfile.h"
 #include <string>
 #include <vector>
 
 using namespace std;
 
+//A board in a fixed size binary form, for keeping positions in files and
+//passing them around without the text format. It holds the occupied squares
+//and the piece on each, two pieces to a byte, so it doesn't have the hashes.
+class PackedBoard
+{
+    public:
+    Int64 occupied;            //squares that have a piece on them
+    unsigned char pieces[16];  //piece on each occupied square from the
+                               //lowest index up, the first of each pair in
+                               //the low 4 bits
+    unsigned short turnNumber;
+    unsigned char sideToMove;
+    unsigned char stepsLeft;
+    unsigned char reserved[4]; //unused, zeroed
+};
+
 class Board
 {
     public:
@@ -23,7 +40,12 @@ class Board
     void reset();
 
     void loadPositionFile(string filename);
+    void loadPositionText(TextRange text);
     void genRandomHashes();
+    Int64 getHashPartsCheck();
+
+    void encode(PackedBoard& packed);
+    void decode(const PackedBoard& packed);
 
     bool isFrozen(unsigned char index, unsigned char piece);
     bool hasFriends(unsigned char index, unsigned char piece);
@@ -48,6 +70,7 @@ class Board
 
     void changeTurn();
     void unchangeTurn(unsigned int oldStepsLeft);
+    Int64 getChangedTurnHash();
 
     unsigned int genMoves(vector<StepCombo>& combos);
     unsigned int genDependentMoves(vector<StepCombo>& combos,
@@ -57,6 +80,7 @@ class Board
                                   StepCombo& ignoreMove);
     unsigned int genMovesToSquare(vector<StepCombo>& combos, unsigned char to,
                                   StepCombo& ignoreMove);
+    unsigned int genTacticalMoves(vector<StepCombo>& combos);
     bool gen1Step(StepCombo& combo, unsigned char from, unsigned char to);
     bool gen2Step(StepCombo& combo, unsigned char from1, unsigned char to1,
                                     unsigned char from2);
@@ -0,0 +1,296 @@
+#include "book.h"
+#include "board.h"
+#include "error.h"
+#include "gamehist.h"
+#include "gamerecord.h"
+#include "hashmem.h"
+#include "int64.h"
+#include "piece.h"
+#include "square.h"
+#include "step.h"
+#include "textfile.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//////////////////////////////////////////////////////////////////////////////
+//Constructor, starts with no book
+//////////////////////////////////////////////////////////////////////////////
+Book :: Book()
+{
+    block.memory = 0;
+    block.bytes = 0;
+    block.pageMode = HASH_MEM_NONE;
+    block.numNodes = 1;
+    entries = 0;
+    numEntries = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Deconstructor, unmaps the book
+//////////////////////////////////////////////////////////////////////////////
+Book :: ~Book()
+{
+    freeHashMem(block);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Opens a book file made by build(). The board is only used to check the book
+//was made with the same hash parts. Returns false, leaving the book empty,
+//if the file can't be used.
+//////////////////////////////////////////////////////////////////////////////
+bool Book :: open(string filename, Board& board)
+{
+    freeHashMem(block);
+    entries = 0;
+    numEntries = 0;
+
+    ifstream in(filename.c_str(), ios::in | ios::binary);
+    if (!in.is_open())
+        return false;
+
+    BookHeader header;
+    in.read((char*)&header, sizeof(header));
+    in.close();
+
+    if (!in || header.magic != BOOK_MAGIC || header.version != BOOK_VERSION ||
+        header.hashPartsCheck != board.getHashPartsCheck() ||
+        header.numEntries == 0)
+    {
+        return false;
+    }
+
+    if (!mapHashMemFile(block, filename, HASH_MEM_FILE_ALIGN,
+                        header.numEntries * sizeof(BookEntry)))
+        return false;
+
+    entries = (BookEntry*)block.memory;
+    numEntries = header.numEntries;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Returns the number of entries in the book
+//////////////////////////////////////////////////////////////////////////////
+Int64 Book :: getNumEntries()
+{
+    return numEntries;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Looks up the board's position in the book. If a move from it has been
+//played in at least BOOK_MIN_GAMES games, the one that won the most games
+//is written to the move given and true is returned. Moves that don't fit
+//the board or would repeat a position a third time are left out.
+//////////////////////////////////////////////////////////////////////////////
+bool Book :: getMove(Board& board, GameHistTable& gameHist, StepCombo& move)
+{
+    BookEntry key;
+    memset(&key, 0, sizeof(key));
+    key.hash = board.hashPiecesOnly;
+    key.sideToMove = board.sideToMove;
+
+    //the empty move in the key comes before any other move, so this finds
+    //the first move from the position
+    BookEntry* entry = lower_bound(entries, entries + numEntries, key);
+
+    BookEntry* best = 0;
+    for (; entry < entries + numEntries && entry->hash == key.hash &&
+           entry->sideToMove == key.sideToMove; entry++)
+    {
+        if (entry->numPlayed < BOOK_MIN_GAMES)
+            continue;
+
+        if (best != 0 && (entry->numWins < best->numWins ||
+                          (entry->numWins == best->numWins &&
+                           entry->numPlayed <= best->numPlayed)))
+            continue;
+
+        StepCombo entryMove;
+        if (isPlayable(board, gameHist, *entry, entryMove))
+        {
+            best = entry;
+            move = entryMove;
+        }
+    }
+
+    return best != 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Makes the move of an entry and checks it can be played on the board, that
+//is every step moves a piece that is there to an empty square, the position
+//is changed, and it doesn't occur a third time. This guards against
+//positions that share a hash. Returns true and writes the move if it can
+//be played.
+//////////////////////////////////////////////////////////////////////////////
+bool Book :: isPlayable(Board& board, GameHistTable& gameHist,
+                        BookEntry& entry, StepCombo& move)
+{
+    move.reset();
+    for (int i = 0; i < entry.numSteps; i++)
+    {
+        Step step;
+        step.data = entry.steps[i];
+        move.addStep(step);
+    }
+
+    if (move.stepCost == 0 || move.stepCost > board.stepsLeft)
+        return false;
+
+    Int64 turnRefer = board.hashPiecesOnly;
+    int numPlayed = 0;
+    bool playable = true;
+    for (; numPlayed < move.numSteps; numPlayed++)
+    {
+        Step step = move.steps[numPlayed];
+        if (board.getPieceAt(step.getFrom()) != step.getPiece() ||
+            (!step.isCapture() &&
+             board.getPieceAt(step.getTo()) != NO_PIECE))
+        {
+            playable = false;
+            break;
+        }
+
+        board.playStep(step);
+    }
+
+    if (playable)
+    {
+        unsigned char oldStepsLeft = board.stepsLeft;
+        board.changeTurn();
+        playable = board.hashPiecesOnly != turnRefer &&
+                   gameHist.getNumOccur(board.hashPiecesOnly) < 2;
+        board.unchangeTurn(oldStepsLeft);
+    }
+
+    //take back the steps played, in reverse
+    while (numPlayed > 0)
+        board.undoStep(move.steps[--numPlayed]);
+
+    return playable;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Builds a book file from a file of games, in the format GameRecordReader
+//reads. Moves up to the max turn of each game are counted, and the moves of
+//the player that won, if the game has a result, count as wins. The board
+//given is used for its hash parts, which have to be the ones used when the
+//book is opened.
+//////////////////////////////////////////////////////////////////////////////
+void Book :: build(string gameFile, string bookFile, Board& board,
+                   unsigned int maxTurn, ostream& log)
+{
+    TextFile in;
+    if (!in.open(gameFile))
+    {
+        Error error;
+        error << "From Book :: build\n"
+              << "Could not open file: "
+              << gameFile << "\n";
+        throw error;
+    }
+
+    Board readBoard = board;
+    GameRecordReader reader(in.getText());
+    GameRecord game;
+
+    vector<BookEntry> allEntries;
+    unsigned int numGames = 0;
+
+    while (reader.nextGame(game))
+    {
+        game.setupBoard(readBoard);
+
+        //the moves alternate from gold's move on turn 2
+        for (unsigned int i = 0; i < game.moves.size() &&
+             i / 2 + 2 <= maxTurn; i++)
+        {
+            StepCombo& steps = game.moves[i];
+
+            BookEntry entry;
+            memset(&entry, 0, sizeof(entry));
+            entry.hash = readBoard.hashPiecesOnly;
+            entry.sideToMove = readBoard.sideToMove;
+            entry.numSteps = steps.numSteps;
+            for (int j = 0; j < steps.numSteps; j++)
+                entry.steps[j] = steps.steps[j].data;
+            entry.numPlayed = 1;
+            if (entry.sideToMove == game.winner)
+                entry.numWins = 1;
+            allEntries.push_back(entry);
+
+            readBoard.playCombo(steps);
+            readBoard.changeTurn();
+        }
+
+        numGames++;
+    }
+
+    //Sort the entries so the same moves from the same positions are
+    //together, then add up their counts
+    sort(allEntries.begin(), allEntries.end());
+
+    vector<BookEntry> bookEntries;
+    for (unsigned int i = 0; i < allEntries.size(); i++)
+    {
+        if (!bookEntries.empty() &&
+            bookEntries.back().hash == allEntries[i].hash &&
+            bookEntries.back().sideToMove == allEntries[i].sideToMove &&
+            bookEntries.back().sameMoveCompare(allEntries[i]) == 0)
+        {
+            bookEntries.back().numPlayed += allEntries[i].numPlayed;
+            bookEntries.back().numWins += allEntries[i].numWins;
+        }
+        else
+        {
+            bookEntries.push_back(allEntries[i]);
+        }
+    }
+
+    ofstream out(bookFile.c_str(), ios::out | ios::binary | ios::trunc);
+    if (!out.is_open())
+    {
+        Error error;
+        error << "From Book :: build\n"
+              << "Could not open file: "
+              << bookFile << "\n";
+        throw error;
+    }
+
+    BookHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = BOOK_MAGIC;
+    header.version = BOOK_VERSION;
+    header.hashPartsCheck = board.getHashPartsCheck();
+    header.numEntries = bookEntries.size();
+    header.maxTurn = maxTurn;
+
+    //pad the header so the entries can be mapped
+    vector<char> padding(HASH_MEM_FILE_ALIGN - sizeof(header), 0);
+    out.write((const char*)&header, sizeof(header));
+    out.write(&padding[0], padding.size());
+    if (!bookEntries.empty())
+    {
+        out.write((const char*)&bookEntries[0],
+                  bookEntries.size() * sizeof(BookEntry));
+    }
+    out.close();
+
+    if (!out)
+    {
+        Error error;
+        error << "From Book :: build\n"
+              << "Could not write file: "
+              << bookFile << "\n";
+        throw error;
+    }
+
+    log << numGames << " games, " << bookEntries.size()
+        << " moves from positions up to turn " << maxTurn << endl;
+}
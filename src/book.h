@@ -0,0 +1,112 @@
+#ifndef __JR_BOOK_H__
+#define __JR_BOOK_H__
+
+//Opening book of moves played from positions early in game records
+
+#include "board.h"
+#include "gamehist.h"
+#include "hashmem.h"
+#include "int64.h"
+#include "step.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+//identifies a file as an opening book ("JRBK" read as little endian bytes),
+//and the version of its layout
+#define BOOK_MAGIC   0x4B42524A
+#define BOOK_VERSION 1
+
+//default last turn of each game that is put in the book
+#define BOOK_MAX_TURN 10
+
+//number of times a move has to have been played to be taken from the book
+#define BOOK_MIN_GAMES 2
+
+using namespace std;
+
+//Header at the start of a book file. The header is followed by padding up to
+//HASH_MEM_FILE_ALIGN bytes, and then the entries.
+class BookHeader
+{
+    public:
+    unsigned int magic;     //always BOOK_MAGIC
+    unsigned int version;   //always BOOK_VERSION
+    Int64 hashPartsCheck;   //mix of the board's random hash parts, as the
+                            //entries are only good with the same hash parts
+    Int64 numEntries;       //number of entries
+    unsigned int maxTurn;   //last turn of each game put in the book
+};
+
+//Statistics on one move played from one position. The entries in a book are
+//sorted by position, so all the moves from a position are next to each
+//other and can be found with a binary search.
+class BookEntry
+{
+    public:
+    //////////////////////////////////////////////////////////////////////////
+    //Orders entries by position and then by move
+    //////////////////////////////////////////////////////////////////////////
+    bool operator<(const BookEntry& comp) const
+    {
+        if (hash != comp.hash)
+            return hash < comp.hash;
+        if (sideToMove != comp.sideToMove)
+            return sideToMove < comp.sideToMove;
+        return sameMoveCompare(comp) < 0;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //Compares the moves of two entries. Returns a negative number, 0, or a
+    //positive number if this move comes before, is the same as, or comes
+    //after the other move
+    //////////////////////////////////////////////////////////////////////////
+    int sameMoveCompare(const BookEntry& comp) const
+    {
+        if (numSteps != comp.numSteps)
+            return numSteps - comp.numSteps;
+        for (int i = 0; i < numSteps; i++)
+        {
+            if (steps[i] != comp.steps[i])
+                return steps[i] - comp.steps[i];
+        }
+        return 0;
+    }
+
+    Int64 hash;                 //hashPiecesOnly at the start of the turn
+    unsigned short steps[8];    //data of the steps of the move
+    unsigned int numPlayed;     //number of games the move was played in
+    unsigned int numWins;       //number of those games the mover won
+    unsigned char sideToMove;   //player to move at the start of the turn
+    unsigned char numSteps;     //number of steps in the move
+};
+
+//Opening book that is looked up before searching. The book file is mapped
+//into memory, so opening even a large book is immediate, and only the pages
+//a lookup touches are ever read.
+class Book
+{
+    public:
+    Book();
+    ~Book();
+
+    bool open(string filename, Board& board);
+    bool getMove(Board& board, GameHistTable& gameHist, StepCombo& move);
+    Int64 getNumEntries();
+
+    static void build(string gameFile, string bookFile, Board& board,
+                      unsigned int maxTurn, ostream& log);
+
+    private:
+    Book(const Book& copy);
+    Book& operator=(const Book& copy);
+
+    bool isPlayable(Board& board, GameHistTable& gameHist, BookEntry& entry,
+                    StepCombo& move);
+
+    HashMemBlock block;   //the mapped entries
+    BookEntry* entries;   //sorted array of entries
+    Int64 numEntries;     //number of entries
+};
+
+#endif
@@ -5,9 +5,122 @@
 #include <fstream>
 #include <list>
 #include <string>
+#include <string.h>
+#include <immintrin.h>
 
 using namespace std;
 
+//starting value of the FNV-1a hash used as the weight file checksum
+#define FNV_OFFSET_BASIS 2166136261u
+
+//////////////////////////////////////////////////////////////////////////////
+//Returns the sum of the position weights of all pieces on the board, in
+//gold's perspective, by going through each piece one at a time.
+//////////////////////////////////////////////////////////////////////////////
+short positionScoreScalar(const Int64 pieces[MAX_COLORS][MAX_TYPES],
+                 const short posWeights[MAX_COLORS][MAX_TYPES][NUM_SQUARES])
+{
+    short positionScore = 0;
+
+    for (int pieceColor = 0; pieceColor < MAX_COLORS; ++pieceColor)
+    {
+        for (int type = 0; type < MAX_TYPES; ++type)
+        {
+            Int64 b = pieces[pieceColor][type];
+            int pos;
+
+            //Go through all squares where this particular piece is
+            while ((pos = bitScanForward(b)) != NO_BIT_FOUND)
+            {
+                b ^= Int64FromIndex(pos);
+                
+                //modify the score accordingly
+                if (pieceColor == GOLD)
+                    positionScore += posWeights[GOLD][type][pos];
+                else
+                    positionScore -= posWeights[SILVER][type][pos];
+            }
+        }
+    }
+
+    return positionScore;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Same as positionScoreScalar, but uses AVX2 to expand each bitboard 16 
+//squares at a time into a mask over that part of the weight row, and sums
+//the masked weights. Lane j of a color's sum adds the weights of squares j,
+//j + 16, j + 32 and j + 48 over all the piece types of that color, and each
+//square has at most one piece, so a lane gets at most four weights. That
+//can't overflow 16 bits as long as position weights stay within +-8191,
+//far more than the few hundred the weight files use.
+//////////////////////////////////////////////////////////////////////////////
+__attribute__((target("avx2")))
+short positionScoreAVX2(const Int64 pieces[MAX_COLORS][MAX_TYPES],
+                 const short posWeights[MAX_COLORS][MAX_TYPES][NUM_SQUARES])
+{
+    //the bit each 16-bit lane looks at
+    const __m256i bitSelect = _mm256_setr_epi16(0x1, 0x2, 0x4, 0x8, 0x10,
+                                  0x20, 0x40, 0x80, 0x100, 0x200, 0x400,
+                                  0x800, 0x1000, 0x2000, 0x4000, 
+                                  (short)0x8000);
+
+    __m256i goldSum   = _mm256_setzero_si256();
+    __m256i silverSum = _mm256_setzero_si256();
+
+    for (int pieceColor = 0; pieceColor < MAX_COLORS; ++pieceColor)
+    {
+        for (int type = 0; type < MAX_TYPES; ++type)
+        {
+            Int64 b = pieces[pieceColor][type];
+            if (!b)
+                continue;
+
+            __m256i sum = _mm256_setzero_si256();
+            for (int part = 0; part < 4; ++part)
+            {
+                __m256i partBits = _mm256_set1_epi16((short)(b >> (16 * part)));
+                __m256i mask = _mm256_cmpeq_epi16(
+                                   _mm256_and_si256(partBits, bitSelect), 
+                                   bitSelect);
+                __m256i weights = _mm256_loadu_si256((const __m256i*)
+                                  &posWeights[pieceColor][type][16 * part]);
+                sum = _mm256_add_epi16(sum, _mm256_and_si256(mask, weights));
+            }
+
+            if (pieceColor == GOLD)
+                goldSum = _mm256_add_epi16(goldSum, sum);
+            else
+                silverSum = _mm256_add_epi16(silverSum, sum);
+        }
+    }
+
+    //add up the lanes, widening to 32 bits first
+    __m256i ones = _mm256_set1_epi16(1);
+    __m256i total = _mm256_sub_epi32(_mm256_madd_epi16(goldSum, ones),
+                                     _mm256_madd_epi16(silverSum, ones));
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(total),
+                                 _mm256_extracti128_si256(total, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+
+    return (short)_mm_cvtsi128_si32(half);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Picks the fastest position score function the processor supports
+//////////////////////////////////////////////////////////////////////////////
+PositionScoreFunc selectPositionScoreFunc()
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return positionScoreAVX2;
+    
+    return positionScoreScalar;
+}
+
+PositionScoreFunc positionScoreFunc = selectPositionScoreFunc();
+
 //////////////////////////////////////////////////////////////////////////////
 //Clear all stored data from a previous search such as history score data.
 //////////////////////////////////////////////////////////////////////////////
@@ -24,8 +137,10 @@ short Eval :: evalBoard(Board& board, unsigned char color)
 {
     //Check first if there is an entry in the hash table for this position
     EvalHashEntry entry;
+    ++numLookups;
     if (hashTable.getEntry(board.hashPiecesOnly, entry))
     {
+        ++numHashHits;
         if (color == GOLD)
             return entry.score;
         else
@@ -52,28 +167,7 @@ short Eval :: evalBoard(Board& board, unsigned char color)
                            - materialWeights[RABBIT][numBits(board.pieces[SILVER][RABBIT])];
 
     //scores for static positions
-    short positionScore = 0;
-
-    for (int pieceColor = 0; pieceColor < MAX_COLORS; ++pieceColor)
-    {
-        for (int type = 0; type < MAX_TYPES; ++type)
-        {
-            Int64 b = board.pieces[pieceColor][type];
-            int pos;
-
-            //Go through all squares where this particular piece is
-            while ((pos = bitScanForward(b)) != NO_BIT_FOUND)
-            {
-                b ^= Int64FromIndex(pos);
-                
-                //modify the score accordingly
-                if (pieceColor == GOLD)
-                    positionScore += posWeights[GOLD][type][pos];
-                else
-                    positionScore -= posWeights[SILVER][type][pos];
-            }
-        }
-    }
+    short positionScore = positionScoreFunc(board.pieces, posWeights);
 
     //scores for frozen pieces
     short frozenScore = 0;
@@ -110,6 +204,92 @@ short Eval :: evalBoard(Board& board, unsigned char color)
         return -score;
 }
 
+//////////////////////////////////////////////////////////////////////////////
+//Evaluates many boards at once, writing the score of each board in the
+//perspective of its side to move to the output array. Gives the same scores
+//as evalBoard, but doesn't use the eval hash table. The bitboards are
+//gathered into arrays indexed by board so that each term is computed in a
+//tight loop over all the boards, which the compiler can vectorize.
+//////////////////////////////////////////////////////////////////////////////
+void Eval :: evalBatch(const Board* boards, size_t n, short* out)
+{
+    Int64 pieces[MAX_COLORS][MAX_TYPES][EVAL_BATCH_SIZE];
+    Int64 strong[MAX_COLORS][EVAL_BATCH_SIZE];
+    Int64 notNear[MAX_COLORS][EVAL_BATCH_SIZE];
+    short scores[EVAL_BATCH_SIZE];
+
+    for (size_t first = 0; first < n; first += EVAL_BATCH_SIZE)
+    {
+        size_t count = n - first;
+        if (count > EVAL_BATCH_SIZE)
+            count = EVAL_BATCH_SIZE;
+
+        const Board* batch = boards + first;
+
+        //gather the bitboards
+        for (int color = 0; color < MAX_COLORS; ++color)
+            for (int type = 0; type < MAX_TYPES; ++type)
+                for (size_t i = 0; i < count; ++i)
+                    pieces[color][type][i] = batch[i].pieces[color][type];
+
+        //static positions
+        for (size_t i = 0; i < count; ++i)
+            scores[i] = positionScoreFunc(batch[i].pieces, posWeights);
+
+        //material
+        for (int type = 0; type < MAX_TYPES; ++type)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                scores[i] += 
+                    materialWeights[type][numBits(pieces[GOLD][type][i])]
+                  - materialWeights[type][numBits(pieces[SILVER][type][i])];
+            }
+        }
+
+        //frozen pieces
+        for (int color = 0; color < MAX_COLORS; ++color)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                Int64 all = 0;
+                for (int type = 0; type < MAX_TYPES; ++type)
+                    all |= pieces[color][type][i];
+
+                strong[color][i]  = pieces[color][ELEPHANT][i];
+                notNear[color][i] = ~near(all);
+            }
+        }
+
+        for (int type = CAMEL; type < MAX_TYPES; type++)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                scores[i] += frozenWeights[type - 1]
+                                    [numBits(pieces[GOLD][type][i] 
+                                    & near(strong[SILVER][i])
+                                    & notNear[GOLD][i])]
+                           - frozenWeights[type - 1]
+                                    [numBits(pieces[SILVER][type][i] 
+                                    & near(strong[GOLD][i])
+                                    & notNear[SILVER][i])];
+
+                //Update the strong pieces for the next type iteration
+                strong[GOLD][i]   |= pieces[GOLD][type][i];
+                strong[SILVER][i] |= pieces[SILVER][type][i];
+            }
+        }
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (batch[i].sideToMove == GOLD)
+                out[first + i] = scores[i];
+            else
+                out[first + i] = -scores[i];
+        }
+    }
+}
+
 //////////////////////////////////////////////////////////////////////////////
 //returns true if the position is a win for the color specified.
 //////////////////////////////////////////////////////////////////////////////
@@ -163,7 +343,25 @@ void Eval :: scoreCombos(vector<StepCombo>& combos, unsigned char color)
 }
 
 //////////////////////////////////////////////////////////////////////////////
-//Load weights from the file specified
+//Sets the position weight for a piece type on a square on the left hand side
+//of the board in gold's perspective. The weight is mirrored onto the right
+//hand side, and onto silver's side of the board.
+//////////////////////////////////////////////////////////////////////////////
+void Eval :: setPosWeight(int type, int row, int col, short weight)
+{
+    //write two values for gold, one for each side of the board.
+    posWeights[GOLD][type][row * 8 + col] = weight;
+    posWeights[GOLD][type][row * 8 + 7 - col] = weight;
+
+    //write two values for silver, which are just mirrored 
+    //horizontally from gold's positions
+    posWeights[SILVER][type][(7 - row) * 8 + col] = weight;
+    posWeights[SILVER][type][(7 - row) * 8 + 7 - col] = weight;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Load weights from the file specified, which can be either in the text
+//format or the binary format
 //////////////////////////////////////////////////////////////////////////////
 void Eval :: loadWeights(string filename)
 {
@@ -177,6 +375,25 @@ void Eval :: loadWeights(string filename)
         throw error;
     }
 
+    //Check if this is a binary weight file instead of a text one
+    unsigned int magic = 0;
+    fin.read((char*)&magic, sizeof(magic));
+    if (fin.gcount() == sizeof(magic) && magic == EVAL_WEIGHTS_MAGIC)
+    {
+        fin.close();
+        loadBinaryWeights(filename);
+        return;
+    }
+    fin.clear();
+    fin.seekg(0);
+
+    //The text format only lists the weights up to the most pieces of each
+    //type there can be, so start from zero to keep the rest of each array
+    //the same in binary files and their checksums
+    memset(materialWeights, 0, sizeof(materialWeights));
+    memset(posWeights, 0, sizeof(posWeights));
+    memset(frozenWeights, 0, sizeof(frozenWeights));
+
     //Material Weights////////////////////////////////////////////////////////
     for (int type = 0; type < MAX_TYPES; type++)
     {   
@@ -236,14 +453,7 @@ void Eval :: loadWeights(string filename)
                 short weight;
                 lineStream >> weight;
 
-                //write two values for gold, one for each side of the board.
-                posWeights[GOLD][type][row * 8 + col] = weight;
-                posWeights[GOLD][type][row * 8 + 7 - col] = weight;
-
-                //write two values for silver, which are just mirrored 
-                //horizontally from gold's positions
-                posWeights[SILVER][type][(7 - row) * 8 + col] = weight;
-                posWeights[SILVER][type][(7 - row) * 8 + 7 - col] = weight;
+                setPosWeight(type, row, col, weight);
             }
         }
         
@@ -389,3 +599,126 @@ void Eval :: saveWeights(string filename)
     fout.close(); 
 }
 
+
+//////////////////////////////////////////////////////////////////////////////
+//Returns the FNV-1a hash given after the bytes given are added to it
+//////////////////////////////////////////////////////////////////////////////
+static unsigned int hashBytes(unsigned int hash, const unsigned char* bytes,
+                              unsigned int size)
+{
+    for (unsigned int i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Load weights from a binary weight file, which is read all at once. Throws
+//an Error if the file can't be read, is of a different version, or doesn't
+//match its checksum
+//////////////////////////////////////////////////////////////////////////////
+void Eval :: loadBinaryWeights(string filename)
+{
+    ifstream fin(filename.c_str(), ios::in | ios::binary);
+
+    if (!fin.is_open())
+    {
+        Error error;
+        error << "From Eval :: loadBinaryWeights\n";
+        error << "Couldn't open file " << filename << "\n";
+        throw error;
+    }
+
+    const unsigned int payloadSize = sizeof(materialWeights) 
+                                   + sizeof(posWeights)
+                                   + sizeof(frozenWeights);
+
+    char buffer[sizeof(EvalWeightsHeader) + payloadSize];
+    fin.read(buffer, sizeof(buffer));
+    unsigned int bytesRead = fin.gcount();
+    fin.close();
+
+    EvalWeightsHeader header;
+    memcpy(&header, buffer, sizeof(header));
+
+    if (bytesRead != sizeof(buffer) || header.magic != EVAL_WEIGHTS_MAGIC ||
+        header.version != EVAL_WEIGHTS_VERSION || 
+        header.payloadSize != payloadSize)
+    {
+        Error error;
+        error << "From Eval :: loadBinaryWeights\n";
+        error << "Invalid header or size in file " << filename << "\n";
+        throw error;
+    }
+
+    //check the payload before copying it, so the weights are left as they
+    //were if the file is corrupt
+    char* payload = buffer + sizeof(header);
+    if (hashBytes(FNV_OFFSET_BASIS, (unsigned char*)payload, payloadSize) 
+        != header.checksum)
+    {
+        Error error;
+        error << "From Eval :: loadBinaryWeights\n";
+        error << "Checksum mismatch in file " << filename << "\n";
+        throw error;
+    }
+
+    memcpy(materialWeights, payload, sizeof(materialWeights));
+    payload += sizeof(materialWeights);
+    memcpy(posWeights, payload, sizeof(posWeights));
+    payload += sizeof(posWeights);
+    memcpy(frozenWeights, payload, sizeof(frozenWeights));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Save weights to the specified file in the binary format
+//////////////////////////////////////////////////////////////////////////////
+void Eval :: saveBinaryWeights(string filename)
+{
+    ofstream fout(filename.c_str(), ios::out | ios::binary);
+
+    if (!fout.is_open())
+    {
+        Error error;
+        error << "From Eval :: saveBinaryWeights\n";
+        error << "Couldn't open file " << filename << "\n";
+        throw error;
+    }
+
+    EvalWeightsHeader header;
+    header.magic = EVAL_WEIGHTS_MAGIC;
+    header.version = EVAL_WEIGHTS_VERSION;
+    header.payloadSize = sizeof(materialWeights) + sizeof(posWeights) 
+                       + sizeof(frozenWeights);
+    header.checksum = weightsChecksum();
+
+    fout.write((char*)&header, sizeof(header));
+    fout.write((char*)materialWeights, sizeof(materialWeights));
+    fout.write((char*)posWeights, sizeof(posWeights));
+    fout.write((char*)frozenWeights, sizeof(frozenWeights));
+
+    fout.close();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Returns the FNV-1a hash of the weight arrays, in the order they are
+//written in the binary weight file
+//////////////////////////////////////////////////////////////////////////////
+unsigned int Eval :: weightsChecksum()
+{
+    unsigned int hash = FNV_OFFSET_BASIS;
+
+    const unsigned char* arrays[3] = {(unsigned char*)materialWeights,
+                                      (unsigned char*)posWeights,
+                                      (unsigned char*)frozenWeights};
+    const unsigned int sizes[3] = {sizeof(materialWeights), 
+                                   sizeof(posWeights),
+                                   sizeof(frozenWeights)};
+
+    for (int i = 0; i < 3; i++)
+        hash = hashBytes(hash, arrays[i], sizes[i]);
+
+    return hash;
+}
@@ -10,28 +10,72 @@
 
 //functions and structures used for scoring heurisitics
 
+//binary weight file constants. The magic number spells "JRWT" at the start
+//of the file
+#define EVAL_WEIGHTS_MAGIC   0x5457524A
+#define EVAL_WEIGHTS_VERSION 1
+
+//number of boards evalBatch works on together
+#define EVAL_BATCH_SIZE 64
+
+//Header at the start of a binary weight file. It is followed by the
+//material, position and frozen weight arrays exactly as laid out in Eval,
+//in the machine's byte order.
+class EvalWeightsHeader
+{
+    public:
+    unsigned int magic;       //EVAL_WEIGHTS_MAGIC
+    unsigned int version;     //EVAL_WEIGHTS_VERSION
+    unsigned int payloadSize; //number of bytes of weights after the header
+    unsigned int checksum;    //FNV-1a hash of the bytes after the header
+};
+
 using namespace std;
 
+//Functions to sum up the position weights for all the pieces on the board.
+//The AVX2 version is only used if the processor supports it, the function
+//picked is kept in positionScoreFunc
+typedef short (*PositionScoreFunc)(
+                 const Int64 pieces[MAX_COLORS][MAX_TYPES],
+                 const short posWeights[MAX_COLORS][MAX_TYPES][NUM_SQUARES]);
+
+short positionScoreScalar(const Int64 pieces[MAX_COLORS][MAX_TYPES],
+                 const short posWeights[MAX_COLORS][MAX_TYPES][NUM_SQUARES]);
+short positionScoreAVX2(const Int64 pieces[MAX_COLORS][MAX_TYPES],
+                 const short posWeights[MAX_COLORS][MAX_TYPES][NUM_SQUARES]);
+
+extern PositionScoreFunc positionScoreFunc;
+
 class Eval
 {
     public:
     Eval()
     {
+        numLookups = 0;
+        numHashHits = 0;
         reset();
     }
     void reset();
 
     short evalBoard(Board& board, unsigned char color); 
+    void evalBatch(const Board* boards, size_t n, short* out);
     bool isWin(Board& board, unsigned char color);
 
     void scoreCombos(vector<StepCombo>& combos, unsigned char color);
 
     void loadWeights(string filename);
     void saveWeights(string filename);
+    void loadBinaryWeights(string filename);
+    void saveBinaryWeights(string filename);
+    unsigned int weightsChecksum();
+    void setPosWeight(int type, int row, int col, short weight);
 
     HistoryScoreTable histTable; // store heurisitic scores for move ordering
     EvalHashTable     hashTable; // keep hashtable for storing evaluations
 
+    unsigned int numLookups;  // number of positions evaluated
+    unsigned int numHashHits; // number of those found in the hash table
+
     //evaluation weights////////////////////////
 
     //static material weights for types and number of that type on the 
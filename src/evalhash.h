@@ -24,27 +24,20 @@ class EvalHashTable
 {
     public:
     //////////////////////////////////////////////////////////////////////////
-    //sets the table size to handle all keys that have the specified number of
-    //bits. That is the table is set to 2 ^ (numbits) entries. Also sets the
-    //hash mask to enforce that keys are limited to that number of bits
+    //sets the table to have the specified number of entries, which need not
+    //be a power of 2
     //////////////////////////////////////////////////////////////////////////
-    void setHashKeySize(unsigned int numBits)
+    void setNumEntries(Int64 numEntries)
     {
-        hashes.init(Int64FromIndex(numBits));
-        hashMask = Int64LowerBitsFilled(numBits);
+        hashes.init(numEntries);
     }
 
     //////////////////////////////////////////////////////////////////////////
-    //Reset every entry
+    //Reset every entry to a score, hash and useful count of 0
     //////////////////////////////////////////////////////////////////////////
     void reset()
     {
-        for (int i = 0; i < hashes.getNumEntries(); i++)
-        {
-            hashes.getEntry(i).score = 0;
-            hashes.getEntry(i).hash = 0;
-            hashes.getEntry(i).useful = 0;
-        }
+        hashes.clear();
     }
 
     //////////////////////////////////////////////////////////////////////////
@@ -55,7 +48,7 @@ class EvalHashTable
     //////////////////////////////////////////////////////////////////////////
     bool getEntry(Int64 hash, EvalHashEntry& out)
     {
-        EvalHashEntry& entry = hashes.getEntry(hash & hashMask);
+        EvalHashEntry& entry = hashes.getEntry(hashes.getIndex(hash));
         if (entry.hash == hash)
         {
             out = entry;
@@ -76,7 +69,7 @@ class EvalHashTable
     //////////////////////////////////////////////////////////////////////////
     void setEntry(Int64 hash, short score)
     {
-        EvalHashEntry& entry = hashes.getEntry(hash & hashMask);
+        EvalHashEntry& entry = hashes.getEntry(hashes.getIndex(hash));
 
         if (entry.hash != hash)
         {
@@ -97,12 +90,25 @@ class EvalHashTable
         entry.useful = 1;
     }
 
+    //////////////////////////////////////////////////////////////////////////
+    //Starts loading the entry for that hash key into the cache
+    //////////////////////////////////////////////////////////////////////////
+    void prefetch(Int64 hash)
+    {
+        hashes.prefetch(hashes.getIndex(hash));
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //Returns a description of the memory the table was given
+    //////////////////////////////////////////////////////////////////////////
+    string getMemDescription()
+    {
+        return hashes.getMemDescription();
+    }
+
     private:
     //Internal hash table to keep the entries
     HashTable<EvalHashEntry> hashes;
-
-    //Mask to limit bits on accessing hashes
-    Int64 hashMask;
 };
 
 #endif
@@ -1,43 +1,49 @@
 #ifndef __JR_GAMEHIST_H__
 #define __JR_GAMEHIST_H__
 
-#include "hash.h"
 #include "int64.h"
+#include <vector>
+
+//smallest number of entries the game history table keeps. It is doubled
+//whenever it gets half full
+#define GAME_HIST_MIN_ENTRIES 64
+
+using namespace std;
 
 //Hash entry to see how many times a position occurred at the end of a turn
 //Used for enforcing 3-repeat rule
 class GameHistEntry
 {
     public:
-    unsigned char numOccur; // number of times this position has occurred
-    
+    Int64 hash;             // the complete hash of the position
+    unsigned char numOccur; // number of times this position has occurred,
+                            // an entry with no occurences is empty
 };
 
-//Table to keep game history table
+//Table to keep game history table. As a game only has a few hundred
+//positions, this is a small open addressing table that keeps the complete
+//hash of each position, so different positions never share an entry.
+//Entries are removed as soon as they have no occurences, so positions that
+//are only added and removed during a search don't fill the table.
 class GameHistTable
 {
     public:
-    //////////////////////////////////////////////////////////////////////////
-    //sets the table size to handle all keys that have the specified number of 
-    //bits. That is the table is set to 2 ^ (numbits) entries. Also sets the
-    //hash mask to enforce that keys are limited to that number of bits
-    //////////////////////////////////////////////////////////////////////////
-    void setHashKeySize(unsigned int numBits)
+    GameHistTable()
     {
-        hashes.init(Int64FromIndex(numBits)); 
-        hashMask = Int64LowerBitsFilled(numBits);        
+        reset();
     }
 
     //////////////////////////////////////////////////////////////////////////
-    //Reset every entry to have no occurences
+    //Reset the table to have no occurences
     //////////////////////////////////////////////////////////////////////////
     void reset()
     {
-        
-        for (int i = 0; i < hashes.getNumEntries(); i++)
-        {
-            hashes.getEntry(i).numOccur = 0;
-        }
+        GameHistEntry empty;
+        empty.hash = 0;
+        empty.numOccur = 0;
+
+        entries.assign(GAME_HIST_MIN_ENTRIES, empty);
+        numUsed = 0;
     }
 
     //////////////////////////////////////////////////////////////////////////
@@ -45,8 +51,23 @@ class GameHistTable
     //////////////////////////////////////////////////////////////////////////
     void incrementOccur(Int64 hash)
     {
-        if (hashes.getEntry(hash & hashMask).numOccur < 255)
-            hashes.getEntry(hash & hashMask).numOccur++;
+        unsigned int index = find(hash);
+
+        if (entries[index].numOccur == 0)
+        {
+            //new position, make sure there is room for it
+            if ((numUsed + 1) * 2 > entries.size())
+            {
+                grow();
+                index = find(hash);
+            }
+
+            entries[index].hash = hash;
+            ++numUsed;
+        }
+
+        if (entries[index].numOccur < 255)
+            entries[index].numOccur++;
     }
 
     //////////////////////////////////////////////////////////////////////////
@@ -54,8 +75,13 @@ class GameHistTable
     //////////////////////////////////////////////////////////////////////////
     void decrementOccur(Int64 hash)
     {
-        if (hashes.getEntry(hash & hashMask).numOccur > 0)
-            hashes.getEntry(hash & hashMask).numOccur--;
+        unsigned int index = find(hash);
+
+        if (entries[index].numOccur == 0)
+            return;
+
+        if (--entries[index].numOccur == 0)
+            remove(index);
     }
 
     //////////////////////////////////////////////////////////////////////////
@@ -63,15 +89,82 @@ class GameHistTable
     //////////////////////////////////////////////////////////////////////////
     unsigned char getNumOccur(Int64 hash)
     {
-        return hashes.getEntry(hash & hashMask).numOccur;
+        return entries[find(hash)].numOccur;
     }
 
     private:
-    //Internal hash table to keep the entries
-    HashTable<GameHistEntry> hashes;
+    //////////////////////////////////////////////////////////////////////////
+    //Returns the index of the entry for that hash, or the index of the empty
+    //entry where it would go if it isn't in the table
+    //////////////////////////////////////////////////////////////////////////
+    unsigned int find(Int64 hash)
+    {
+        unsigned int mask = entries.size() - 1;
+        unsigned int index = hash & mask;
+
+        while (entries[index].numOccur != 0 && entries[index].hash != hash)
+            index = (index + 1) & mask;
+
+        return index;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //Empties the entry at that index, and moves back any entries after it
+    //that would no longer be found because of the gap
+    //////////////////////////////////////////////////////////////////////////
+    void remove(unsigned int index)
+    {
+        unsigned int mask = entries.size() - 1;
+        entries[index].numOccur = 0;
+        --numUsed;
+
+        unsigned int next = index;
+        while (true)
+        {
+            next = (next + 1) & mask;
+            if (entries[next].numOccur == 0)
+                break;
+
+            //the entry can stay if the index it hashes to is after the gap,
+            //going around the end of the table
+            unsigned int home = entries[next].hash & mask;
+            bool stays;
+            if (index <= next)
+                stays = index < home && home <= next;
+            else
+                stays = index < home || home <= next;
+
+            if (!stays)
+            {
+                entries[index] = entries[next];
+                entries[next].numOccur = 0;
+                index = next;
+            }
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //Doubles the number of entries, placing all the current entries again
+    //////////////////////////////////////////////////////////////////////////
+    void grow()
+    {
+        vector<GameHistEntry> old = entries;
+
+        GameHistEntry empty;
+        empty.hash = 0;
+        empty.numOccur = 0;
+        entries.assign(old.size() * 2, empty);
+
+        for (unsigned int i = 0; i < old.size(); i++)
+        {
+            if (old[i].numOccur != 0)
+                entries[find(old[i].hash)] = old[i];
+        }
+    }
 
-    //Mask to limit bits on accessing hashes
-    Int64 hashMask;
+    vector<GameHistEntry> entries; //array of entries, the size is always
+                                   //a power of 2
+    unsigned int numUsed;          //number of entries with occurences
 };
 
 #endif
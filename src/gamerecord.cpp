@@ -0,0 +1,450 @@
+#include "gamerecord.h"
+#include "board.h"
+#include "error.h"
+#include "int64.h"
+#include "piece.h"
+#include "square.h"
+#include "step.h"
+#include "textfile.h"
+#include <chrono>
+#include <ctype.h>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+//////////////////////////////////////////////////////////////////////////////
+//Empties the game
+//////////////////////////////////////////////////////////////////////////////
+void GameRecord :: reset()
+{
+    numPlaced = 0;
+    moves.clear();
+    winner = MAX_COLORS;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Resets the board and places the pieces of the first turn on it, which
+//leaves it at the start of the second turn with gold to move. The hash has
+//the turn in it, the same as a board loaded from a position file.
+//////////////////////////////////////////////////////////////////////////////
+void GameRecord :: setupBoard(Board& board)
+{
+    board.reset();
+    for (int i = 0; i < numPlaced; i++)
+    {
+        unsigned char piece = placedPieces[i];
+        board.writePieceOnBoard(placedSquares[i], colorOfPiece(piece),
+                                typeOfPiece(piece));
+    }
+
+    board.turnNumber = 2;
+    board.hash ^= board.hashTurnParts[GOLD];
+    board.hash ^= board.hashStepsLeftParts[4];
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Returns true if the word is the label of gold's first turn, which starts a
+//new game
+//////////////////////////////////////////////////////////////////////////////
+static bool isGameStart(TextRange& word)
+{
+    return word.equals("1w") || word.equals("1g");
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Returns the start of the first line after the position given that starts
+//a game, or the end of the text if there is none
+//////////////////////////////////////////////////////////////////////////////
+static const char* findGameStart(const char* from, const char* end)
+{
+    TextRange rest;
+    rest.begin = from;
+    rest.end = end;
+
+    //start from the next whole line
+    TextRange line;
+    if (!rest.nextLine(line))
+        return end;
+
+    const char* lineStart = rest.begin;
+    while (rest.nextLine(line))
+    {
+        TextRange word;
+        if (line.nextWord(word) && isGameStart(word))
+            return lineStart;
+        lineStart = rest.begin;
+    }
+
+    return end;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Constructor, reads games from the text given, which has to stay in memory
+//while the reader is used
+//////////////////////////////////////////////////////////////////////////////
+GameRecordReader :: GameRecordReader(TextRange text)
+{
+    this->text = text;
+    numSkipped = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Reads the next game into the record given. Returns false if there are no
+//more games.
+//////////////////////////////////////////////////////////////////////////////
+bool GameRecordReader :: nextGame(GameRecord& game)
+{
+    while (text.begin < text.end)
+    {
+        try
+        {
+            if (readGame(game))
+                return true;
+        }
+        catch (Error error)
+        {
+            numSkipped++;
+            skipGame();
+        }
+    }
+
+    return false;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Reads lines into the game until it ends. Returns false if the lines read
+//had no game in them. Throws an Error if the game can't be read.
+//////////////////////////////////////////////////////////////////////////////
+bool GameRecordReader :: readGame(GameRecord& game)
+{
+    game.reset();
+
+    TextRange line;
+    const char* lineStart = text.begin;
+    while (text.nextLine(line))
+    {
+        TextRange word;
+        if (!line.nextWord(word))
+        {
+            lineStart = text.begin;
+            continue;
+        }
+
+        bool hasMoves = game.numPlaced > 0 || !game.moves.empty();
+
+        if (word.equals("result"))
+        {
+            line.nextWord(word);
+            if (word.equals("w") || word.equals("g"))
+                game.winner = GOLD;
+            else if (word.equals("b") || word.equals("s"))
+                game.winner = SILVER;
+
+            if (hasMoves)
+                return true;
+
+            lineStart = text.begin;
+            continue;
+        }
+
+        //leave the start of the next game to be read next time
+        if (isGameStart(word) && hasMoves)
+        {
+            text.begin = lineStart;
+            return true;
+        }
+        lineStart = text.begin;
+
+        if (!isdigit(*word.begin))
+        {
+            Error error;
+            error << "From GameRecordReader :: readGame\n"
+                  << "Expected turn number as first part in line\n"
+                  << "Got: " << word.toString() << '\n';
+            throw error;
+        }
+
+        int turnNumber = 0;
+        while (word.begin < word.end && isdigit(*word.begin))
+            turnNumber = turnNumber * 10 + (*word.begin++ - '0');
+
+        //a takeback undoes the last move
+        TextRange rest = line;
+        if (rest.nextWord(word) && word.equals("takeback"))
+        {
+            if (game.moves.empty())
+            {
+                Error error;
+                error << "From GameRecordReader :: readGame\n"
+                      << "Can't take back a first turn placement\n";
+                throw error;
+            }
+
+            game.moves.pop_back();
+            continue;
+        }
+
+        if (turnNumber == 1)
+        {
+            //the pieces placed on the first turn
+            while (line.nextWord(word))
+            {
+                if (word.length() != 3 || game.numPlaced == 32)
+                {
+                    Error error;
+                    error << "From GameRecordReader :: readGame\n"
+                          << "Invalid Format for piece placement\n"
+                          << "Got: " << word.toString() << '\n';
+                    throw error;
+                }
+
+                unsigned char piece = pieceFromChar(word.begin[0]);
+                game.placedPieces[game.numPlaced] = piece;
+                game.placedSquares[game.numPlaced] =
+                                        squareFromChars(word.begin + 1, 2);
+                game.numPlaced++;
+            }
+        }
+        else if (!line.isBlank())
+        {
+            //the last line of a game is usually an empty move, which is
+            //left out
+            game.moves.push_back(StepCombo());
+            game.moves.back().fromChars(line.begin, line.end);
+        }
+    }
+
+    return game.numPlaced > 0 || !game.moves.empty();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Skips the rest of the game being read, up to its result line or the start
+//of the next game
+//////////////////////////////////////////////////////////////////////////////
+void GameRecordReader :: skipGame()
+{
+    TextRange line;
+    const char* lineStart = text.begin;
+    while (text.nextLine(line))
+    {
+        TextRange word;
+        if (!line.nextWord(word))
+            continue;
+
+        if (word.equals("result"))
+            return;
+
+        if (isGameStart(word))
+        {
+            text.begin = lineStart;
+            return;
+        }
+
+        lineStart = text.begin;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Splits the text of an archive into about even parts, each starting at the
+//start of a game, so the parts can be read by separate readers. There are
+//fewer parts if the text has too few games.
+//////////////////////////////////////////////////////////////////////////////
+void GameRecordReader :: split(TextRange text, int numParts,
+                               vector<TextRange>& parts)
+{
+    parts.clear();
+
+    Int64 length = text.end - text.begin;
+    TextRange part;
+    part.begin = text.begin;
+    for (int i = 1; i <= numParts && part.begin < text.end; i++)
+    {
+        part.end = text.end;
+        if (i < numParts)
+        {
+            const char* target = text.begin + length * i / numParts;
+            if (target < part.begin)
+                target = part.begin;
+            part.end = findGameStart(target, text.end);
+        }
+
+        if (part.end > part.begin)
+            parts.push_back(part);
+        part.begin = part.end;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Adds a record of the position on the board to the records
+//////////////////////////////////////////////////////////////////////////////
+static void addPositionRecord(Board& board, unsigned char winner,
+                              vector<PositionRecord>& records)
+{
+    PositionRecord record;
+    memset(&record, 0, sizeof(record));
+    board.encode(record.board);
+    record.winner = winner;
+    records.push_back(record);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Replays the games in the text on a copy of the board, and adds a record
+//of every position a move was played from or the game ended in. Used by
+//each thread of extractPositions.
+//////////////////////////////////////////////////////////////////////////////
+static void extractPart(Board board, TextRange text,
+                        vector<PositionRecord>& records,
+                        unsigned int& numGames, unsigned int& numSkipped)
+{
+    GameRecordReader reader(text);
+    GameRecord game;
+    numGames = 0;
+    numSkipped = 0;
+
+    while (reader.nextGame(game))
+    {
+        //Moves that don't fit the board can leave more pieces than can be
+        //packed, so the records of a game are only kept if they all are
+        unsigned int gameStart = records.size();
+        try
+        {
+            game.setupBoard(board);
+            addPositionRecord(board, game.winner, records);
+
+            for (unsigned int i = 0; i < game.moves.size(); i++)
+            {
+                board.playCombo(game.moves[i]);
+                board.changeTurn();
+                if (board.sideToMove == GOLD)
+                    board.turnNumber++;
+                addPositionRecord(board, game.winner, records);
+            }
+
+            numGames++;
+        }
+        catch (Error error)
+        {
+            records.resize(gameStart);
+            numSkipped++;
+        }
+    }
+
+    numSkipped += reader.numSkipped;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Reads all the games of an archive, in the format GameRecordReader reads,
+//and writes every position in them to a position file. Each game gives the
+//position after the setup and the position after each move. The archive is
+//read in parts of GAME_RECORD_PART_BYTES, and each part is split between
+//the threads. Returns the number of positions written.
+//////////////////////////////////////////////////////////////////////////////
+Int64 extractPositions(string archiveFile, string positionFile,
+                       int numThreads, ostream& log)
+{
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    if (numThreads < 1)
+        numThreads = 1;
+
+    TextFile in;
+    if (!in.open(archiveFile))
+    {
+        Error error;
+        error << "From extractPositions\n"
+              << "Could not open file: "
+              << archiveFile << "\n";
+        throw error;
+    }
+
+    ofstream out(positionFile.c_str(), ios::out | ios::binary | ios::trunc);
+    if (!out.is_open())
+    {
+        Error error;
+        error << "From extractPositions\n"
+              << "Could not open file: "
+              << positionFile << "\n";
+        throw error;
+    }
+
+    //the number of records is filled in at the end
+    PositionFileHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = POSITION_FILE_MAGIC;
+    header.version = POSITION_FILE_VERSION;
+    out.write((const char*)&header, sizeof(header));
+
+    Board board;
+    board.genRandomHashes();
+
+    Int64 numGames = 0;
+    Int64 numSkipped = 0;
+    TextRange rest = in.getText();
+    while (rest.begin < rest.end)
+    {
+        TextRange part = rest;
+        if (rest.end - rest.begin > GAME_RECORD_PART_BYTES)
+        {
+            part.end = findGameStart(rest.begin + GAME_RECORD_PART_BYTES,
+                                     rest.end);
+        }
+        rest.begin = part.end;
+
+        vector<TextRange> threadParts;
+        GameRecordReader::split(part, numThreads, threadParts);
+
+        int numParts = threadParts.size();
+        vector<vector<PositionRecord> > records(numParts);
+        vector<unsigned int> partGames(numParts);
+        vector<unsigned int> partSkipped(numParts);
+        vector<thread> threads;
+        for (int t = 0; t < numParts; t++)
+        {
+            threads.push_back(thread(extractPart, board, threadParts[t],
+                                     ref(records[t]), ref(partGames[t]),
+                                     ref(partSkipped[t])));
+        }
+
+        //write the records in the order of the archive
+        for (int t = 0; t < numParts; t++)
+        {
+            threads[t].join();
+
+            numGames += partGames[t];
+            numSkipped += partSkipped[t];
+            header.numRecords += records[t].size();
+            if (!records[t].empty())
+            {
+                out.write((const char*)&records[t][0],
+                          records[t].size() * sizeof(PositionRecord));
+            }
+        }
+    }
+
+    out.seekp(0);
+    out.write((const char*)&header, sizeof(header));
+    out.close();
+
+    if (!out)
+    {
+        Error error;
+        error << "From extractPositions\n"
+              << "Could not write file: "
+              << positionFile << "\n";
+        throw error;
+    }
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now()
+                                              - start).count();
+    log << "Extracted " << header.numRecords << " positions from "
+        << numGames << " games in " << seconds << " seconds, "
+        << numSkipped << " games skipped" << endl;
+
+    return header.numRecords;
+}
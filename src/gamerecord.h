@@ -0,0 +1,91 @@
+#ifndef __JR_GAMERECORD_H__
+#define __JR_GAMERECORD_H__
+
+//Reading of archives of many game records, and extraction of the positions
+//in them to a binary file
+
+#include "board.h"
+#include "int64.h"
+#include "piece.h"
+#include "step.h"
+#include "textfile.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+//identifies a position file, and the version of its format
+#define POSITION_FILE_MAGIC   0x5350524A
+#define POSITION_FILE_VERSION 2
+
+//number of characters of the archive that are read into positions at once
+//when extracting. Each part is split between the threads, and the positions
+//of one part are written before the next part is read.
+#define GAME_RECORD_PART_BYTES (16 * 1024 * 1024)
+
+using namespace std;
+
+//A game read from an archive, as the pieces placed on the first turn and
+//the moves played after
+class GameRecord
+{
+    public:
+    void reset();
+    void setupBoard(Board& board);
+
+    unsigned char placedPieces[32];  //pieces placed on the first turn
+    unsigned char placedSquares[32]; //squares they were placed on
+    int numPlaced;                   //number of pieces placed
+
+    vector<StepCombo> moves;         //moves played from the second turn on
+
+    unsigned char winner;            //player that won, or MAX_COLORS if the
+                                     //game has no result
+};
+
+//Reads the games of an archive one at a time. The archive is a list of
+//games in the same move list format as the move files. Each game can end
+//with a line "result w" or "result b" (or g/s) saying who won, and a game
+//without one ends where the next game starts at a line for turn 1g. Games
+//that can't be read are skipped.
+class GameRecordReader
+{
+    public:
+    GameRecordReader(TextRange text);
+
+    bool nextGame(GameRecord& game);
+
+    static void split(TextRange text, int numParts,
+                      vector<TextRange>& parts);
+
+    unsigned int numSkipped; //number of games skipped so far
+
+    private:
+    bool readGame(GameRecord& game);
+    void skipGame();
+
+    TextRange text; //the rest of the archive still to be read
+};
+
+//A position from a game, as stored in a position file
+class PositionRecord
+{
+    public:
+    PackedBoard board;           //the position, turn and side to move
+    unsigned char winner;        //player that won the game, or MAX_COLORS
+                                 //if it isn't known
+    unsigned char padding[7];    //unused, zeroed
+};
+
+//Start of a position file, which is followed by the records
+class PositionFileHeader
+{
+    public:
+    unsigned int magic;     //POSITION_FILE_MAGIC
+    unsigned int version;   //POSITION_FILE_VERSION
+    Int64 numRecords;       //number of records following
+};
+
+Int64 extractPositions(string archiveFile, string positionFile,
+                       int numThreads, ostream& log);
+
+#endif
@@ -4,23 +4,132 @@
 //hash table data structures to keep data for transpositions
 
 #include "int64.h"
+#include "hashmem.h"
 #include <assert.h>
 #include <string.h>
-#include <vector>
+#include <string>
+#include <ostream>
 
 using namespace std;
 
-//Generic Hash table template class
+//Generic Hash table template class. The entries are kept in memory from
+//allocHashMem, so large tables get huge pages when the system has them.
+//Entries start out zeroed, and the table keeps track of whether any entry
+//has been handed out since, so clearing a table that was never used doesn't
+//touch its memory at all.
 template <class T>
 class HashTable
 {
     public:
+    HashTable()
+    {
+        entries = 0;
+        numEntries = 0;
+        isClean = true;
+        block.memory = 0;
+        block.bytes = 0;
+        block.pageMode = HASH_MEM_NONE;
+        block.numNodes = 1;
+    }
+
+    HashTable(const HashTable<T>& copy)
+    {
+        entries = 0;
+        numEntries = 0;
+        block.pageMode = HASH_MEM_NONE;
+        *this = copy;
+    }
+
+    ~HashTable()
+    {
+        freeHashMem(block);
+    }
+
+    HashTable<T>& operator=(const HashTable<T>& copy)
+    {
+        if (this != &copy)
+        {
+            init(copy.numEntries);
+            if (!copy.isClean)
+            {
+                memcpy(entries, copy.entries, numEntries * sizeof(T));
+                isClean = false;
+            }
+        }
+        return *this;
+    }
+
 	//////////////////////////////////////////////////////////////////////////
-	//initializes the hashtable with the specified number of entries
+	//initializes the hashtable with the specified number of entries, all
+	//zeroed
 	//////////////////////////////////////////////////////////////////////////
     void init(Int64 numEntries)
 	{
-		entries.resize(numEntries);
+        freeHashMem(block);
+        entries = 0;
+        this->numEntries = numEntries;
+        isClean = true;
+
+        if (numEntries > 0)
+        {
+            allocHashMem(block, numEntries * sizeof(T));
+            entries = (T*)block.memory;
+        }
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	//initializes the hashtable with the specified number of entries, taken
+	//from a file written by write() at that offset. The entries are read
+	//from the file as they are used, and changing them doesn't change the
+	//file. Returns false, leaving the table with no entries, if the file
+	//doesn't have that many entries there.
+	//////////////////////////////////////////////////////////////////////////
+    bool mapFile(string filename, Int64 offset, Int64 numEntries)
+    {
+        freeHashMem(block);
+        entries = 0;
+        this->numEntries = 0;
+        isClean = true;
+
+        if (!mapHashMemFile(block, filename, offset, numEntries * sizeof(T)))
+            return false;
+
+        entries = (T*)block.memory;
+        this->numEntries = numEntries;
+        isClean = false;
+        return true;
+    }
+
+	//////////////////////////////////////////////////////////////////////////
+	//writes every entry to the stream as raw bytes
+	//////////////////////////////////////////////////////////////////////////
+    void write(ostream& out)
+    {
+        out.write((const char*)entries, numEntries * sizeof(T));
+    }
+
+	//////////////////////////////////////////////////////////////////////////
+	//sets every entry back to zero. This is done in parallel over all cores,
+	//and not at all if no entry has been used since the last time.
+	//////////////////////////////////////////////////////////////////////////
+    void clear()
+    {
+        if (!isClean)
+        {
+            clearHashMem(block);
+            isClean = true;
+        }
+    }
+
+	//////////////////////////////////////////////////////////////////////////
+	//returns the index of the entry to use for a hash key. The key is
+	//multiplied by the number of entries, and the upper 64 bits of the
+	//product are kept, which spreads the keys evenly over a table of any
+	//size, not just powers of 2. Note this uses the upper bits of the key.
+	//////////////////////////////////////////////////////////////////////////
+	Int64 getIndex(Int64 key)
+	{
+		return ((unsigned __int128)key * numEntries) >> 64;
 	}
 
 	//////////////////////////////////////////////////////////////////////////
@@ -28,21 +137,42 @@ class HashTable
 	//////////////////////////////////////////////////////////////////////////
 	T& getEntry(Int64 key)
 	{
+		isClean = false;
 		return entries[key];
 	}
 
+    //////////////////////////////////////////////////////////////////////////
+    //Starts loading the entry at that index into the cache, so that it is
+    //already there when it is used a little later. This doesn't count as
+    //using the entry.
+    //////////////////////////////////////////////////////////////////////////
+    void prefetch(Int64 key)
+    {
+        __builtin_prefetch(&entries[key]);
+    }
+
     //////////////////////////////////////////////////////////////////////////
     //Returns the number of entries
     //////////////////////////////////////////////////////////////////////////
-    unsigned int getNumEntries()
+    Int64 getNumEntries()
+    {
+        return numEntries;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //Returns a description of the memory the entries were given
+    //////////////////////////////////////////////////////////////////////////
+    string getMemDescription()
     {
-        return entries.size();
+        return hashMemDescription(block);
     }
 
     private:
 
-    vector<T> entries;       //array of entries in the hashtable
+    T* entries;        //array of entries in the hashtable
     Int64 numEntries;  //number of entries
-};    
+    bool isClean;      //true if every entry is known to still be zero
+    HashMemBlock block; //the memory the entries are kept in
+};
 
 #endif
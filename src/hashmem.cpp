@@ -0,0 +1,273 @@
+#include "hashmem.h"
+#include "error.h"
+#include "int64.h"
+#include <fstream>
+#include <stdio.h>
+#include <sstream>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/mempolicy.h>
+
+using namespace std;
+
+//whether new blocks should be interleaved over all NUMA nodes
+static bool interleaveHashMem = false;
+
+//////////////////////////////////////////////////////////////////////////////
+//Sets whether blocks allocated from now on should have their pages spread
+//evenly over all NUMA nodes, which helps when several threads on different
+//sockets probe the same table.
+//////////////////////////////////////////////////////////////////////////////
+void setHashMemInterleave(bool interleave)
+{
+    interleaveHashMem = interleave;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Reads the online NUMA nodes from sysfs into a node mask. Returns the number
+//of nodes found, or 0 if they couldn't be read.
+//////////////////////////////////////////////////////////////////////////////
+static int getOnlineNodes(unsigned long& nodeMask)
+{
+    ifstream in("/sys/devices/system/node/online");
+    if (!in.is_open())
+        return 0;
+
+    //The file is a list of single nodes and ranges of nodes such as 0-1,3
+    string list;
+    getline(in, list);
+    stringstream listStream(list);
+
+    nodeMask = 0;
+    int numNodes = 0;
+    string range;
+    while (getline(listStream, range, ','))
+    {
+        int first, last;
+        if (sscanf(range.c_str(), "%d-%d", &first, &last) != 2)
+        {
+            if (sscanf(range.c_str(), "%d", &first) != 1)
+                continue;
+            last = first;
+        }
+
+        for (int node = first; node <= last && node < 64; node++)
+        {
+            nodeMask |= (unsigned long)1 << node;
+            numNodes++;
+        }
+    }
+
+    return numNodes;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Allocates a zeroed block of memory for a hash table. Tries explicit huge
+//pages first, then regular pages with a request for transparent huge pages.
+//The pages are only touched when first used, so a large block costs nothing
+//until the search gets to it. Throws an Error if no memory could be mapped.
+//////////////////////////////////////////////////////////////////////////////
+void allocHashMem(HashMemBlock& block, Int64 bytes)
+{
+    block.memory = MAP_FAILED;
+    block.numNodes = 1;
+
+    if (bytes == 0)
+        bytes = 1;
+
+    if (bytes >= HASH_MEM_HUGE_PAGE_SIZE)
+    {
+        //huge page mappings have to be a whole number of huge pages
+        Int64 hugeBytes = (bytes + HASH_MEM_HUGE_PAGE_SIZE - 1)
+                        / HASH_MEM_HUGE_PAGE_SIZE * HASH_MEM_HUGE_PAGE_SIZE;
+
+        //Note the huge pages have to be reserved up front, otherwise the
+        //mapping can succeed and then fault when there are none left
+        block.memory = mmap(0, hugeBytes, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                            -1, 0);
+        block.bytes = hugeBytes;
+        block.pageMode = HASH_MEM_HUGETLB;
+    }
+
+    if (block.memory == MAP_FAILED)
+    {
+        block.memory = mmap(0, bytes, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                            -1, 0);
+        block.bytes = bytes;
+        block.pageMode = HASH_MEM_NORMAL;
+
+        if (block.memory == MAP_FAILED)
+        {
+            block.memory = 0;
+            block.pageMode = HASH_MEM_NONE;
+
+            Error error;
+            error << "From allocHashMem\n"
+                  << "Could not map " << (int)(bytes / 1024)
+                  << " KB for a hash table\n";
+            throw error;
+        }
+
+        if (bytes >= HASH_MEM_HUGE_PAGE_SIZE &&
+            madvise(block.memory, bytes, MADV_HUGEPAGE) == 0)
+        {
+            block.pageMode = HASH_MEM_TRANSPARENT;
+        }
+    }
+
+    //Spread the pages over the nodes before any of them are touched
+    unsigned long nodeMask;
+    int numNodes;
+    if (interleaveHashMem && (numNodes = getOnlineNodes(nodeMask)) > 1)
+    {
+        if (syscall(SYS_mbind, block.memory, block.bytes, MPOL_INTERLEAVE,
+                    &nodeMask, sizeof(nodeMask) * 8, 0) == 0)
+        {
+            block.numNodes = numNodes;
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Maps the given range of a file as a block of hash memory. The mapping is
+//private, so the table can be changed freely without changing the file, and
+//pages are only read from the file when they are first used. The offset has
+//to be a multiple of HASH_MEM_FILE_ALIGN. Returns false, leaving the block
+//empty, if the file doesn't have that range or couldn't be mapped.
+//////////////////////////////////////////////////////////////////////////////
+bool mapHashMemFile(HashMemBlock& block, string filename, Int64 offset,
+                    Int64 bytes)
+{
+    block.memory = 0;
+    block.bytes = 0;
+    block.pageMode = HASH_MEM_NONE;
+    block.numNodes = 1;
+
+    int file = open(filename.c_str(), O_RDONLY);
+    if (file < 0)
+        return false;
+
+    struct stat fileStat;
+    if (bytes == 0 || offset % HASH_MEM_FILE_ALIGN != 0 ||
+        fstat(file, &fileStat) != 0 || fileStat.st_size < 0 ||
+        (Int64)fileStat.st_size < offset + bytes)
+    {
+        close(file);
+        return false;
+    }
+
+    void* memory = mmap(0, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                        file, offset);
+
+    //the mapping keeps the file open by itself
+    close(file);
+
+    if (memory == MAP_FAILED)
+        return false;
+
+    block.memory = memory;
+    block.bytes = bytes;
+    block.pageMode = HASH_MEM_FILE;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Frees a block allocated with allocHashMem or mapHashMemFile
+//////////////////////////////////////////////////////////////////////////////
+void freeHashMem(HashMemBlock& block)
+{
+    if (block.pageMode != HASH_MEM_NONE)
+        munmap(block.memory, block.bytes);
+
+    block.memory = 0;
+    block.bytes = 0;
+    block.pageMode = HASH_MEM_NONE;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Zeroes every byte of a block. Large blocks are split into chunks that are
+//zeroed by one thread per core at the same time, as a single core can't
+//come close to using all of the memory bandwidth.
+//////////////////////////////////////////////////////////////////////////////
+void clearHashMem(HashMemBlock& block)
+{
+    if (block.pageMode == HASH_MEM_NONE)
+        return;
+
+    char* memory = (char*)block.memory;
+    Int64 numThreads = thread::hardware_concurrency();
+    if (numThreads > block.bytes / HASH_MEM_CLEAR_CHUNK)
+        numThreads = block.bytes / HASH_MEM_CLEAR_CHUNK;
+
+    if (numThreads <= 1)
+    {
+        memset(memory, 0, block.bytes);
+        return;
+    }
+
+    //Give each thread a run of whole pages, with the last thread also
+    //taking what is left over
+    Int64 chunkBytes = block.bytes / numThreads / 4096 * 4096;
+    vector<thread> threads;
+    for (Int64 i = 0; i < numThreads; i++)
+    {
+        Int64 first = i * chunkBytes;
+        Int64 bytes = i == numThreads - 1 ? block.bytes - first : chunkBytes;
+        threads.push_back(thread(memset, memory + first, 0, bytes));
+    }
+
+    for (unsigned int i = 0; i < threads.size(); i++)
+        threads[i].join();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Returns a readable description of how the block was allocated
+//////////////////////////////////////////////////////////////////////////////
+string hashMemDescription(HashMemBlock& block)
+{
+    stringstream description;
+    description << block.bytes / 1024 << " KB ";
+
+    switch (block.pageMode)
+    {
+        case HASH_MEM_NONE:
+        {
+            description << "not allocated";
+        }break;
+
+        case HASH_MEM_NORMAL:
+        {
+            description << "on normal pages";
+        }break;
+
+        case HASH_MEM_TRANSPARENT:
+        {
+            description << "on transparent huge pages";
+        }break;
+
+        case HASH_MEM_HUGETLB:
+        {
+            description << "on explicit huge pages";
+        }break;
+
+        case HASH_MEM_FILE:
+        {
+            description << "mapped from a snapshot file";
+        }break;
+    }
+
+    if (block.numNodes > 1)
+        description << ", interleaved over " << block.numNodes
+                    << " NUMA nodes";
+
+    return description.str();
+}
@@ -0,0 +1,48 @@
+#ifndef __JR_HASHMEM_H__
+#define __JR_HASHMEM_H__
+
+//allocation of the large blocks of memory used by the hash tables
+
+#include "int64.h"
+#include <string>
+
+//kinds of pages a block of hash memory was given
+#define HASH_MEM_NONE        0 //nothing allocated
+#define HASH_MEM_NORMAL      1 //regular pages
+#define HASH_MEM_TRANSPARENT 2 //regular pages, but the kernel was asked to
+                               //back them with transparent huge pages
+#define HASH_MEM_HUGETLB     3 //explicitly reserved huge pages
+#define HASH_MEM_FILE        4 //private mapping of part of a file, pages
+                               //that get written are copied
+
+//blocks smaller than this aren't worth trying to give huge pages
+#define HASH_MEM_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+//offsets of blocks mapped from files have to be a multiple of this
+#define HASH_MEM_FILE_ALIGN 4096
+
+//smallest part of a block each thread is given to zero when clearing it
+#define HASH_MEM_CLEAR_CHUNK (16 * 1024 * 1024)
+
+using namespace std;
+
+//Describes a block of hash memory and how it was allocated
+class HashMemBlock
+{
+    public:
+    void* memory;            //start of the block
+    Int64 bytes;             //number of bytes actually mapped
+    unsigned char pageMode;  //one of the HASH_MEM constants
+    int numNodes;            //number of NUMA nodes the pages are interleaved
+                             //over, 1 if they are not interleaved
+};
+
+void   setHashMemInterleave(bool interleave);
+void   allocHashMem(HashMemBlock& block, Int64 bytes);
+bool   mapHashMemFile(HashMemBlock& block, string filename, Int64 offset,
+                      Int64 bytes);
+void   freeHashMem(HashMemBlock& block);
+void   clearHashMem(HashMemBlock& block);
+string hashMemDescription(HashMemBlock& block);
+
+#endif
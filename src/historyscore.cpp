@@ -64,3 +64,28 @@ void HistoryScoreTable :: increaseScore(RawMove move, unsigned char color,
     scores[move.from1][move.to1][move.from2][color] += ((unsigned int) 1) 
                                                         << depth;
 }      
+
+//////////////////////////////////////////////////////////////////////////////
+//Writes all the scores to the stream as raw bytes
+//////////////////////////////////////////////////////////////////////////////
+void HistoryScoreTable :: write(ostream& out)
+{
+    out.write((const char*)scores, sizeof(scores));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Reads all the scores from a stream written by write(). Returns false, and
+//resets the scores, if the stream ends early.
+//////////////////////////////////////////////////////////////////////////////
+bool HistoryScoreTable :: read(istream& in)
+{
+    in.read((char*)scores, sizeof(scores));
+
+    if (!in)
+    {
+        reset();
+        return false;
+    }
+
+    return true;
+}
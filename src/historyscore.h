@@ -4,6 +4,9 @@
 #include "square.h"
 #include "piece.h"
 #include "rawmove.h"
+#include <iostream>
+
+using namespace std;
 
 //A table to keep track of when moves are the best known move.
 //Used for move ordering.
@@ -14,6 +17,9 @@ class HistoryScoreTable
     void scaleDown();
     unsigned short getScore(RawMove move, unsigned char color);
     void increaseScore(RawMove move, unsigned char color, int depth);
+
+    void write(ostream& out);
+    bool read(istream& in);
     
     private:
     //The actual score table structure. It is indexed as follows:
@@ -1,21 +1,38 @@
 #include "board.h"
 #include "error.h"
+#include "gamerecord.h"
 #include "int64.h"
 #include "step.h"
+#include "textfile.h"
 #include "search.h"
 #include "maxheap.h"
 #include "hash.h"
+#include "tune.h"
+#include "book.h"
+#include "bench.h"
+#include "setup.h"
+#include "treelog.h"
 #include <iostream>
 #include <string>
 #include <time.h>
 #include <fstream>
 #include <cstdlib>
 #include <iomanip>
+#include <thread>
+#include <sstream>
 
 //different behavior modes
 #define MODE_NONE 0
 #define MODE_GAMEROOM 1
 #define MODE_HELP 2
+#define MODE_TUNE 3
+#define MODE_HASHINFO 4
+#define MODE_BUILDBOOK 5
+#define MODE_PARSEBENCH 6
+#define MODE_EXTRACT 7
+#define MODE_PACKTEST 8
+#define MODE_BENCH 9
+#define MODE_TREEQUERY 10
 
 
 using namespace std;
@@ -26,7 +43,10 @@ using namespace std;
 //////////////////////////////////////////////////////////////////////////////
 void gameroom(fstream& logFile, string positionFile, string moveFile,  
               string gamestateFile, string evalWeightFile,
-              int maxDepth, int hashTableBytes)
+              int maxDepth, Int64 hashTableBytes, Int64 tableBytes[3],
+              int quiesceNodes, string snapshotFile, string bookFile,
+              string telemetryFile, string treeLogFile, Int64 treeLogBytes,
+              int numThreads, double setupSeconds)
 {
 
     //start logging, noting the time.
@@ -46,35 +66,274 @@ void gameroom(fstream& logFile, string positionFile, string moveFile,
     logFile << "Loaded file. Board state is:\n";
     logFile << board << endl;
 
-    //if first move, just play fixed position
+    //if first move, search for the setup to play
     if (board.turnNumber == 1)  
     {
-        logFile << "First move, playing fixed position\n";
-        
-        if (board.sideToMove == GOLD)
-        {
-            cout << "Ra1 Rb1 Rc1 Dd1 De1 Rf1 Rg1 Rh1 Ra2 Hb2 Cc2 Md2 Ee2 Cf2 Hg2 Rh2\n";
-        }
-        else
-        {
-            cout << "ra8 rb8 rc8 dd8 de8 rf8 rg8 rh8 ra7 hb7 cc7 md7 ee7 cf7 hg7 rh7\n";
-        }
+        logFile << "First move, searching for a setup\n";
+
+        SetupSearch setupSearch(evalWeightFile, numThreads);
+        string setup = setupSearch.findSetup(board, setupSeconds, logFile);
+
+        logFile << "Doing setup " << setup << endl;
+        cout << setup << endl;
     }
     else //otherwise actually go through a search
     {
         
-        Search search(hashTableBytes);
+        Search search(hashTableBytes, tableBytes[0], tableBytes[1], 
+                      tableBytes[2]);
+        search.quiesceNodeBudget = quiesceNodes;
+
         search.loadMoveFile(moveFile, board);
         search.eval.loadWeights(evalWeightFile);
+
+        //play straight from the opening book if the position is in it
+        Book book;
+        StepCombo bookMove;
+        if (bookFile != string("") && book.open(bookFile, board) &&
+            book.getMove(board, search.gameHistTable, bookMove))
+        {
+            logFile << "Found position in book " << bookFile << endl;
+            logFile << "Doing move " << bookMove.toString() << endl;
+            cout << bookMove.toString() << endl;
+            return;
+        }
+
+        //start with the tables from the last search in this game, if any
+        if (snapshotFile != string(""))
+        {
+            if (search.loadSnapshot(snapshotFile, board))
+                logFile << "Loaded table snapshot " << snapshotFile << endl;
+            else
+                logFile << "No usable table snapshot in " << snapshotFile
+                        << endl;
+        }
+
+        //the telemetry of every search is added to the end of one file
+        ofstream telemetry;
+        if (telemetryFile != string(""))
+        {
+            telemetry.open(telemetryFile.c_str(), ios::out | ios::app);
+            if (!telemetry.good())
+            {
+                Error error;
+                error << "From gameroom\n"
+                      << "Can't open telemetry file " << telemetryFile
+                      << "\n";
+                throw error;
+            }
+            search.telemetry = &telemetry;
+        }
+
+        //record the search tree, to be saved after the search. Without a
+        //file, the log only has room for one record and isn't used.
+        SearchTreeLog treeLog(treeLogFile != string("") ? treeLogBytes : 0);
+        if (treeLogFile != string(""))
+            search.treeLog = &treeLog;
+
+        logFile << "Transposition table "
+                << search.transTable.getMemDescription() << endl
+                << "Search history table "
+                << search.searchHistTable.getMemDescription() << endl
+                << "Eval hash table "
+                << search.eval.hashTable.getMemDescription() << endl;
         
         StepCombo bestMove = search.iterativeDeepen(board, maxDepth, logFile);
                                                     
         logFile << "Finished Search\n";
+
+        if (treeLogFile != string(""))
+        {
+            treeLog.save(treeLogFile);
+            logFile << "Saved search tree log " << treeLogFile << endl;
+        }
+
+        if (snapshotFile != string(""))
+        {
+            search.saveSnapshot(snapshotFile, board);
+            logFile << "Saved table snapshot " << snapshotFile << endl;
+        }
+
         logFile << "Doing move " << bestMove.toString() << endl;
         cout << bestMove.toString() << endl;
     }
 }
 
+//////////////////////////////////////////////////////////////////////////////
+//Writes a move file of a game of random moves with the given number of
+//turns after the setup, taking back and replaying a turn every 100 turns.
+//Used to benchmark loading long games.
+//////////////////////////////////////////////////////////////////////////////
+void writeSyntheticMoveFile(string filename, int numTurns)
+{
+    ofstream out(filename.c_str());
+    if (!out.is_open())
+    {
+        Error error;
+        error << "From writeSyntheticMoveFile\n"
+              << "Could not open file: "
+              << filename << "\n";
+        throw error;
+    }
+
+    out << "1g Ra1 Rb1 Rc1 Dd1 De1 Rf1 Rg1 Rh1 "
+        << "Ra2 Hb2 Cc2 Md2 Ee2 Cf2 Hg2 Rh2\n";
+    out << "1s ra8 rb8 rc8 dd8 de8 rf8 rg8 rh8 "
+        << "ra7 hb7 cc7 md7 ee7 cf7 hg7 rh7\n";
+
+    Board board;
+    board.genRandomHashes();
+    board.reset();
+    stringstream setups("Ra1 Rb1 Rc1 Dd1 De1 Rf1 Rg1 Rh1 "
+                        "Ra2 Hb2 Cc2 Md2 Ee2 Cf2 Hg2 Rh2 "
+                        "ra8 rb8 rc8 dd8 de8 rf8 rg8 rh8 "
+                        "ra7 hb7 cc7 md7 ee7 cf7 hg7 rh7");
+    string word;
+    while (setups >> word)
+    {
+        unsigned char piece = pieceFromChar(word[0]);
+        board.writePieceOnBoard(squareFromString(word.substr(1)),
+                                colorOfPiece(piece), typeOfPiece(piece));
+    }
+
+    vector<StepCombo> combos;
+    for (int turn = 0; turn < numTurns; turn++)
+    {
+        stringstream label;
+        label << turn / 2 + 2 << (board.sideToMove == GOLD ? 'g' : 's');
+
+        //play random moves until the steps run out
+        StepCombo move;
+        while (board.stepsLeft > 0)
+        {
+            combos.clear();
+            board.genMoves(combos);
+
+            //leave out moves that capture, so that the game lasts
+            vector<StepCombo> fitting;
+            for (unsigned int i = 0; i < combos.size(); i++)
+            {
+                if (combos[i].stepCost <= board.stepsLeft &&
+                    combos[i].numSteps == combos[i].stepCost)
+                    fitting.push_back(combos[i]);
+            }
+
+            if (fitting.empty())
+                break;
+
+            StepCombo& combo = fitting[rand() % fitting.size()];
+            board.playCombo(combo);
+            move.addCombo(combo);
+        }
+
+        //a game with no moves left is over
+        if (move.numSteps == 0)
+            break;
+
+        out << label.str() << " " << move.toString() << "\n";
+        if (turn % 100 == 99)
+        {
+            out << (turn + 1) / 2 + 2 
+                << (board.sideToMove == GOLD ? 's' : 'g') << " takeback\n";
+            out << label.str() << " " << move.toString() << "\n";
+        }
+
+        board.changeTurn();
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Returns true if the board gives back the same board after being encoded
+//and decoded
+//////////////////////////////////////////////////////////////////////////////
+bool packRoundTrips(Board& board)
+{
+    PackedBoard packed;
+    board.encode(packed);
+
+    Board decoded = board;
+    decoded.decode(packed);
+
+    for (int color = 0; color < MAX_COLORS; color++)
+        for (int type = 0; type < MAX_TYPES; type++)
+            if (decoded.pieces[color][type] != board.pieces[color][type])
+                return false;
+
+    return decoded.hash == board.hash &&
+           decoded.hashPiecesOnly == board.hashPiecesOnly &&
+           decoded.sideToMove == board.sideToMove &&
+           decoded.stepsLeft == board.stepsLeft &&
+           decoded.turnNumber == board.turnNumber;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Replays the games of an archive a step at a time and checks every position
+//round trips through the packed board format. Throws an Error if any
+//doesn't.
+//////////////////////////////////////////////////////////////////////////////
+void packTest(string archiveFile)
+{
+    TextFile in;
+    if (!in.open(archiveFile))
+    {
+        Error error;
+        error << "From packTest\n"
+              << "Could not open file: "
+              << archiveFile << "\n";
+        throw error;
+    }
+
+    Board board;
+    board.genRandomHashes();
+
+    GameRecordReader reader(in.getText());
+    GameRecord game;
+    int numChecked = 0;
+    int numFailed = 0;
+
+    while (reader.nextGame(game))
+    {
+        game.setupBoard(board);
+        numFailed += !packRoundTrips(board);
+        numChecked++;
+
+        for (unsigned int i = 0; i < game.moves.size(); i++)
+        {
+            StepCombo& move = game.moves[i];
+            if (move.isPass())
+            {
+                board.playCombo(move);
+                numFailed += !packRoundTrips(board);
+                numChecked++;
+            }
+
+            for (int j = 0; j < move.numSteps && !move.isPass(); j++)
+            {
+                board.playStep(move.steps[j]);
+                numFailed += !packRoundTrips(board);
+                numChecked++;
+            }
+
+            board.changeTurn();
+            if (board.sideToMove == GOLD)
+                board.turnNumber++;
+            numFailed += !packRoundTrips(board);
+            numChecked++;
+        }
+    }
+
+    cout << "Checked " << numChecked << " positions, " << numFailed
+         << " did not round trip\n";
+
+    if (numFailed > 0)
+    {
+        Error error;
+        error << "From packTest\n"
+              << numFailed << " positions did not round trip\n";
+        throw error;
+    }
+}
+
 int main(int argc, char * args[])
 {
     //keep a log file
@@ -94,11 +353,60 @@ int main(int argc, char * args[])
         //set hash size to default 50MB.
         Int64 hashTableBytes = 50 * 1024 * 1024;
 
+        //sizes of the transposition, search history, and eval hash tables.
+        //0 means the table gets an even share of the memory left
+        Int64 tableBytes[3] = {0, 0, 0};
+
+        //set the tactical extension node budget to the default
+        int quiesceNodes = SEARCH_QUIESCE_NODE_BUDGET;
+
         string positionFile;
         string moveFile;
         string gamestateFile;
         string evalWeightFile = string("evalWeights/weights.txt");
 
+        //file to keep the tables in between searches, none by default
+        string snapshotFile;
+
+        //file to add the search telemetry to, none by default
+        string telemetryFile;
+
+        //file to save the search tree to, none by default, the size of the
+        //buffer the tree is kept in, and the options for querying one
+        string treeLogFile;
+        Int64 treeLogBytes = TREE_LOG_BYTES;
+        string treeQueryMove;
+
+        //opening book to play from, none by default, and the options for
+        //building one
+        string bookFile;
+        string bookGameFile;
+        int bookMaxTurn = BOOK_MAX_TURN;
+
+        //options for the parser benchmark
+        string parseBenchFile;
+        int parseBenchTurns = 500;
+        int parseBenchLoads = 1000;
+
+        //files to extract the positions of an archive of games between
+        string archiveFile;
+        string positionRecordFile;
+
+        //depth of the search benchmark
+        int benchDepth = BENCH_DEPTH;
+
+        //time the first turn setup search may take
+        double setupSeconds = SETUP_SEARCH_TIME;
+
+        //tuning options
+        string tuneDataFile;
+        string tuneOutputFile;
+        int tuneEpochs = 10;
+        double tuneRate = TUNE_LEARNING_RATE;
+
+        //set number of threads to the number of cores
+        int numThreads = thread::hardware_concurrency();
+
         //parse the arguments to see what behavior is desired.
         for (int i = 1; i < argc; ++i)
         {
@@ -126,9 +434,168 @@ int main(int argc, char * args[])
             }
             else if (string(args[i]) == string("--hashtablesize"))
             {
-                hashTableBytes = atoi(args[i+1]) * 1024 * 1024;
+                hashTableBytes = (Int64)atoi(args[i+1]) * 1024 * 1024;
                 ++i;
             }
+            else if (string(args[i]) == string("--transtablesize"))
+            {
+                tableBytes[0] = (Int64)atoi(args[i+1]) * 1024 * 1024;
+                ++i;
+            }
+            else if (string(args[i]) == string("--searchhistsize"))
+            {
+                tableBytes[1] = (Int64)atoi(args[i+1]) * 1024 * 1024;
+                ++i;
+            }
+            else if (string(args[i]) == string("--evalhashsize"))
+            {
+                tableBytes[2] = (Int64)atoi(args[i+1]) * 1024 * 1024;
+                ++i;
+            }
+            else if (string(args[i]) == string("--quiescenodes"))
+            {
+                quiesceNodes = atoi(args[i+1]);
+                ++i;
+            }
+            else if (string(args[i]) == string("--interleave"))
+            {
+                //spread the hash tables over all NUMA nodes
+                setHashMemInterleave(true);
+            }
+            else if (string(args[i]) == string("--snapshot"))
+            {
+                snapshotFile = args[i+1];
+                ++i;
+            }
+            else if (string(args[i]) == string("--telemetry"))
+            {
+                telemetryFile = args[i+1];
+                ++i;
+            }
+            else if (string(args[i]) == string("--treelog"))
+            {
+                treeLogFile = args[i+1];
+                ++i;
+            }
+            else if (string(args[i]) == string("--treelogsize"))
+            {
+                treeLogBytes = (Int64)atoi(args[i+1]) * 1024 * 1024;
+                ++i;
+            }
+            else if (string(args[i]) == string("--treequery"))
+            {
+                //show what a saved search tree says about the search
+                mode = MODE_TREEQUERY;
+                treeLogFile = args[i+1];
+                ++i;
+            }
+            else if (string(args[i]) == string("--treemove"))
+            {
+                treeQueryMove = args[i+1];
+                ++i;
+            }
+            else if (string(args[i]) == string("--book"))
+            {
+                bookFile = args[i+1];
+                ++i;
+            }
+            else if (string(args[i]) == string("--buildbook"))
+            {
+                //build an opening book from the games in the game file
+                mode = MODE_BUILDBOOK;
+                bookGameFile = args[i+1];
+                bookFile = args[i+2];
+                i += 2;
+            }
+            else if (string(args[i]) == string("--bookmaxturn"))
+            {
+                bookMaxTurn = atoi(args[i+1]);
+                ++i;
+            }
+            else if (string(args[i]) == string("--setuptime"))
+            {
+                setupSeconds = atof(args[i+1]);
+                ++i;
+            }
+            else if (string(args[i]) == string("--parsebench"))
+            {
+                //time loading a synthetic long game from a move file
+                mode = MODE_PARSEBENCH;
+                parseBenchFile = args[i+1];
+                parseBenchTurns = atoi(args[i+2]);
+                parseBenchLoads = atoi(args[i+3]);
+                i += 3;
+            }
+            else if (string(args[i]) == string("--extract"))
+            {
+                //write the positions of all games in the archive to a
+                //binary position file
+                mode = MODE_EXTRACT;
+                archiveFile = args[i+1];
+                positionRecordFile = args[i+2];
+                i += 2;
+            }
+            else if (string(args[i]) == string("--packtest"))
+            {
+                //check positions of the games in the archive encode and
+                //decode to the same board
+                mode = MODE_PACKTEST;
+                archiveFile = args[i+1];
+                ++i;
+            }
+            else if (string(args[i]) == string("--bench"))
+            {
+                //search the benchmark positions and report the speed
+                mode = MODE_BENCH;
+            }
+            else if (string(args[i]) == string("--benchdepth"))
+            {
+                benchDepth = atoi(args[i+1]);
+                ++i;
+            }
+            else if (string(args[i]) == string("--hashinfo"))
+            {
+                mode = MODE_HASHINFO;
+            }
+            else if (string(args[i]) == string("--threads"))
+            {
+                numThreads = atoi(args[i+1]);
+                ++i;
+            }
+            else if (string(args[i]) == string("--tune"))
+            {
+                //tune the eval weights over the games in the data file
+                //and write the weights to the output file
+                mode = MODE_TUNE;
+                tuneDataFile = args[i+1];
+                tuneOutputFile = args[i+2];
+                i += 2;
+            }
+            else if (string(args[i]) == string("--epochs"))
+            {
+                tuneEpochs = atoi(args[i+1]);
+                ++i;
+            }
+            else if (string(args[i]) == string("--tunerate"))
+            {
+                tuneRate = atof(args[i+1]);
+                ++i;
+            }
+            else if (string(args[i]) == string("--weights"))
+            {
+                //use a different eval weight file, in either format
+                evalWeightFile = args[i+1];
+                ++i;
+            }
+            else if (string(args[i]) == string("--convertweights"))
+            {
+                //convert a weight file to the binary format
+                mode = MODE_NONE;
+                Eval eval;
+                eval.loadWeights(args[i+1]);
+                eval.saveBinaryWeights(args[i+2]);
+                i += 2;
+            }
             else if (string(args[i]) == string("--genmoves"))
             {
                 mode = MODE_NONE;
@@ -148,12 +615,13 @@ int main(int argc, char * args[])
             {
                 mode = MODE_NONE;
                 Board board;
+                board.genRandomHashes();
                 positionFile = args[i+1];
                 board.loadPositionFile(positionFile);
 
                 Eval eval;
                 eval.loadWeights(evalWeightFile);
-                eval.hashTable.setHashKeySize(1);
+                eval.hashTable.setNumEntries(1);
                 cout << eval.evalBoard(board, board.sideToMove) << endl;
             }
             else if (string(args[i]) == string("--test"))
@@ -189,6 +657,86 @@ int main(int argc, char * args[])
             cout << "--depth max\nSets the max search depth. Defaults to 4\n\n";
             cout << "--hashtablesize num\nSets the size of the hash table in"
                  << " MB. Defaults to 50\n\n";
+            cout << "--transtablesize num\n--searchhistsize num\n"
+                 << "--evalhashsize num\nSets the size of the transposition"
+                 << " table, search history table,\nor eval hash table in MB."
+                 << " Tables without a size share the rest\nof the hash"
+                 << " table memory evenly\n\n";
+            cout << "--quiescenodes num\nSets the number of nodes the"
+                 << " search can explore past the horizon\nwith captures and"
+                 << " goals per iteration. 0 turns this off. Defaults to "
+                 << SEARCH_QUIESCE_NODE_BUDGET << "\n\n";
+            cout << "--interleave\nSpreads the hash table memory evenly"
+                 << " over all NUMA nodes\n\n";
+            cout << "--snapshot file\nSaves the transposition table and"
+                 << " history scores to the file\nafter a gameroom search,"
+                 << " and starts the next search with them\nif it is later"
+                 << " in the same game\n\n";
+            cout << "--telemetry file\nAdds a JSON record to the file"
+                 << " after each iteration of a\ngameroom search and for"
+                 << " the move played, one record per line\n\n";
+            cout << "--treelog file\nRecords the nodes and moves of a"
+                 << " gameroom search, with the\nwindow, score and reason"
+                 << " of each, and saves them to the file\n\n";
+            cout << "--treelogsize num\nSets the size of the buffer the"
+                 << " search tree is kept in, in MB.\nOnce it is full the"
+                 << " oldest records are dropped. Defaults to "
+                 << TREE_LOG_BYTES / (1024 * 1024) << "\n\n";
+            cout << "--treequery file\nDisplays the root moves of the"
+                 << " last iteration of a saved search\ntree, with the"
+                 << " score of each and why it got it\n\n";
+            cout << "--treemove move\nWith --treequery, follows one"
+                 << " root move, such as Ed5e, through\nevery iteration"
+                 << " instead, with the moves tried after it\n\n";
+            cout << "--book bookFile\nPlays from the opening book in"
+                 << " gameroom mode when the position\nis in it\n\n";
+            cout << "--buildbook gameFile bookFile\nBuilds an opening book"
+                 << " from the games in the game file. The\ngame file is"
+                 << " in the same format as for --tune, but the result\n"
+                 << "lines are optional\n\n";
+            cout << "--bookmaxturn num\nSets the last turn of each game put"
+                 << " in the book. Defaults to " << BOOK_MAX_TURN << "\n\n";
+            cout << "--setuptime seconds\nSets the time the search for"
+                 << " the setup on the first turn\nmay take. Defaults to "
+                 << SETUP_SEARCH_TIME << "\n\n";
+            cout << "--parsebench moveFile turns loads\nWrites a move file"
+                 << " of a random game with that many turns,\nand times"
+                 << " loading it that many times\n\n";
+            cout << "--extract archiveFile positionFile\nWrites every"
+                 << " position of the games in the archive to\na binary"
+                 << " position file. The archive is in the same format as"
+                 << "\nfor --buildbook\n\n";
+            cout << "--packtest archiveFile\nChecks every position of"
+                 << " the games in the archive is the\nsame after being"
+                 << " encoded to the binary board format and decoded\n\n";
+            cout << "--bench\nSearches a fixed suite of positions with"
+                 << " a fixed hash size, and\ndisplays the nodes, time,"
+                 << " nodes/sec and a signature of the node\ncounts, which"
+                 << " only changes if the search does\n\n";
+            cout << "--benchdepth num\nSets the depth of the benchmark"
+                 << " search. Defaults to " << BENCH_DEPTH << "\n\n";
+            cout << "--hashinfo\nAllocates the hash tables with the current"
+                 << " sizes, and displays\nwhat kind of memory each table"
+                 << " was given\n\n";
+            cout << "--weights weightFile\nSets the eval weight file to use,"
+                 << " in either the text or binary\nformat. Defaults to"
+                 << " evalWeights/weights.txt\n\n";
+            cout << "--convertweights weightFile binaryFile\nConverts a"
+                 << " weight file to the binary format, which\nloads"
+                 << " faster\n\n";
+            cout << "--threads num\nSets the number of threads to use"
+                 << " for tuning, extracting\npositions, and the setup"
+                 << " search. Defaults to the"
+                 << " number of cores\n\n";
+            cout << "--tune dataFile outputFile\nTunes the eval weights over"
+                 << " the games in the data file and\nwrites the weights to"
+                 << " the output file. The data file is a list of\ngames in"
+                 << " the move file format, each ending with a line\n"
+                 << "\"result w\" or \"result b\"\n\n";
+            cout << "--epochs num\nSets the number of passes over the data"
+                 << " when tuning. Defaults to 10\n\n";
+            cout << "--tunerate rate\nSets the learning rate when tuning."
+                 << " Defaults to " << TUNE_LEARNING_RATE << "\n\n";
             cout << "--genmoves positionFile\nDisplays the set of moves that"
                  << " the move generator generates from a position\n\n";
             cout << "--eval positionFile\nDisplays the static evaluation"
@@ -199,7 +747,85 @@ int main(int argc, char * args[])
         if (mode == MODE_GAMEROOM)
         {
             gameroom(logFile, positionFile, moveFile, gamestateFile,
-                     evalWeightFile, maxDepth, hashTableBytes);
+                     evalWeightFile, maxDepth, hashTableBytes, tableBytes,
+                     quiesceNodes, snapshotFile, bookFile, telemetryFile,
+                     treeLogFile, treeLogBytes, numThreads, setupSeconds);
+        }
+
+        if (mode == MODE_PARSEBENCH)
+        {
+            writeSyntheticMoveFile(parseBenchFile, parseBenchTurns);
+
+            Board board;
+            board.genRandomHashes();
+            Search search(1024 * 1024);
+
+            time_t reftime = clock();
+            for (int i = 0; i < parseBenchLoads; i++)
+            {
+                search.gameHistTable.reset();
+                search.loadMoveFile(parseBenchFile, board);
+            }
+            double millis = (double)(clock() - reftime) * 1000 
+                          / CLOCKS_PER_SEC;
+
+            cout << "Loaded " << parseBenchTurns << " turns "
+                 << parseBenchLoads << " times in " << millis << " ms, "
+                 << millis / parseBenchLoads << " ms per load, "
+                 << (Int64)(parseBenchTurns * (double)parseBenchLoads
+                            / millis * 1000)
+                 << " turns per second\n";
+        }
+
+        if (mode == MODE_BUILDBOOK)
+        {
+            Board board;
+            board.genRandomHashes();
+            Book::build(bookGameFile, bookFile, board, bookMaxTurn, cout);
+        }
+
+        if (mode == MODE_EXTRACT)
+        {
+            extractPositions(archiveFile, positionRecordFile, numThreads,
+                             cout);
+        }
+
+        if (mode == MODE_PACKTEST)
+        {
+            packTest(archiveFile);
+        }
+
+        if (mode == MODE_BENCH)
+        {
+            runBench(benchDepth, evalWeightFile, cout);
+        }
+
+        if (mode == MODE_TREEQUERY)
+        {
+            queryTreeLog(treeLogFile, treeQueryMove, cout);
+        }
+
+        if (mode == MODE_HASHINFO)
+        {
+            Search search(hashTableBytes, tableBytes[0], tableBytes[1],
+                          tableBytes[2]);
+
+            cout << "Transposition table "
+                 << search.transTable.getMemDescription() << endl
+                 << "Search history table "
+                 << search.searchHistTable.getMemDescription() << endl
+                 << "Eval hash table "
+                 << search.eval.hashTable.getMemDescription() << endl;
+        }
+
+        if (mode == MODE_TUNE)
+        {
+            Eval eval;
+            eval.loadWeights(evalWeightFile);
+
+            Tuner tuner(eval, numThreads);
+            tuner.tune(tuneDataFile, tuneEpochs, tuneRate, cout);
+            eval.saveWeights(tuneOutputFile);
         }
 
         logFile.flush();
@@ -5,6 +5,9 @@
 
 using namespace std;
 
+template<class T>
+void maxHeapSink(vector<T>& heap, unsigned int index);
+
 //////////////////////////////////////////////////////////////////////////////
 //Takes an array and converts it in place to a max-heap data structure, which
 //is basically a binary tree, where each parent is greater than each of its
@@ -0,0 +1,488 @@
+#include "bench.h"
+#include "board.h"
+#include "error.h"
+#include "eval.h"
+#include "int64.h"
+#include "maxheap.h"
+#include "movepicker.h"
+#include "piece.h"
+#include "square.h"
+#include "step.h"
+#include "transposition.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+//number of random moves played from each suite position to make more
+//positions for the corpus
+#define MICROBENCH_WALK_MOVES 8
+
+//size of the hash tables that are probed in bytes, big enough that random
+//probes miss the caches
+#define MICROBENCH_TABLE_BYTES (64 * 1024 * 1024)
+
+//number of random keys to probe the tables with, and the number probed per
+//sample. Each sample probes the next slice of the keys, so the entries it
+//probes haven't been probed recently and aren't still in the caches.
+#define MICROBENCH_NUM_KEYS (1 << 22)
+#define MICROBENCH_KEYS_PER_PASS 4096
+
+//number of moves picked from each list when timing a node that is cut off
+//early
+#define MICROBENCH_EARLY_PICKS 3
+
+using namespace std;
+
+//The positions and tables every primitive is timed on
+class MicroBenchCorpus
+{
+    public:
+    vector<Board> boards;                //positions of the corpus
+    vector<vector<StepCombo> > moves;    //moves generated from each
+    vector<vector<unsigned char> > squares; //occupied squares of each
+    vector<vector<unsigned char> > pieces;  //the pieces on those squares
+    vector<Board> dependentBoards;       //positions just after a one step
+                                         //move from a corpus position
+    vector<StepCombo> dependentMoves;    //the move that was played
+    vector<Int64> keys;                  //random keys to probe tables with
+    unsigned int nextKey;                //first key the next sample probes
+
+    Eval evalMiss;                       //eval with a one entry hash table
+    Eval evalHit;                        //eval with the corpus positions
+                                         //already in its hash table
+    TranspositionTable transTable;       //table to probe
+
+    Int64 sink; //sum of the results, so the work isn't optimized away
+};
+
+//////////////////////////////////////////////////////////////////////////////
+//Fills the corpus with the positions of the search benchmark suite and the
+//positions of random moves played from them
+//////////////////////////////////////////////////////////////////////////////
+void buildCorpus(MicroBenchCorpus& corpus, string evalWeightFile)
+{
+    mt19937 random(1);
+    Board board;
+    board.genRandomHashes();
+
+    for (int i = 0; i < BENCH_NUM_POSITIONS; i++)
+    {
+        loadBenchPosition(board, i);
+        for (int move = 0; move <= MICROBENCH_WALK_MOVES; move++)
+        {
+            vector<StepCombo> combos;
+            board.genMoves(combos);
+            if (combos.empty())
+                break;
+
+            corpus.boards.push_back(board);
+            corpus.moves.push_back(combos);
+
+            vector<unsigned char> squares;
+            vector<unsigned char> pieces;
+            for (int square = 0; square < NUM_SQUARES; square++)
+            {
+                if (board.getPieceAt(square) != NO_PIECE)
+                {
+                    squares.push_back(square);
+                    pieces.push_back(board.getPieceAt(square));
+                }
+            }
+            corpus.squares.push_back(squares);
+            corpus.pieces.push_back(pieces);
+
+            //the positions after each one step move, for dependent moves
+            for (unsigned int j = 0; j < combos.size(); j++)
+            {
+                if (combos[j].stepCost != 1 || j % 4 != 0)
+                    continue;
+
+                Board after = board;
+                after.playCombo(combos[j]);
+                corpus.dependentBoards.push_back(after);
+                corpus.dependentMoves.push_back(combos[j]);
+            }
+
+            //play whole random moves to get to the next position
+            while (board.stepsLeft > 0)
+            {
+                combos.clear();
+                board.genMoves(combos);
+
+                vector<StepCombo> fitting;
+                for (unsigned int j = 0; j < combos.size(); j++)
+                {
+                    if (combos[j].stepCost <= board.stepsLeft)
+                        fitting.push_back(combos[j]);
+                }
+
+                if (fitting.empty())
+                    break;
+
+                board.playCombo(fitting[random() % fitting.size()]);
+            }
+            board.changeTurn();
+        }
+    }
+
+    for (int i = 0; i < MICROBENCH_NUM_KEYS; i++)
+        corpus.keys.push_back(((Int64)random() << 32) | random());
+    corpus.nextKey = 0;
+
+    //with one entry, and no two positions in a row the same, every position
+    //misses the hash table of the first eval
+    corpus.evalMiss.loadWeights(evalWeightFile);
+    corpus.evalMiss.hashTable.setNumEntries(1);
+
+    corpus.evalHit.loadWeights(evalWeightFile);
+    corpus.evalHit.hashTable.setNumEntries(MICROBENCH_TABLE_BYTES
+                                           / sizeof(EvalHashEntry));
+    //A new table's memory may not be given out until it is written, and
+    //random probes would all read the same zero page, so every entry is
+    //zeroed once by using one and clearing the table
+    corpus.evalHit.hashTable.setEntry(0, 0);
+    corpus.evalHit.hashTable.reset();
+    for (unsigned int i = 0; i < corpus.boards.size(); i++)
+        corpus.evalHit.evalBoard(corpus.boards[i], GOLD);
+
+    //give the moves their move ordering scores
+    for (unsigned int i = 0; i < corpus.boards.size(); i++)
+        corpus.evalHit.scoreCombos(corpus.moves[i],
+                                   corpus.boards[i].sideToMove);
+
+    corpus.transTable.setNumEntries(MICROBENCH_TABLE_BYTES
+                                    / sizeof(TranspositionEntry));
+    corpus.transTable.getEntry(0);
+    corpus.transTable.reset();
+    corpus.sink = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Each primitive below is run once over the whole corpus, and returns the
+//number of times the primitive was called
+//////////////////////////////////////////////////////////////////////////////
+
+Int64 benchPlayUndoStep(MicroBenchCorpus& corpus)
+{
+    Int64 numOps = 0;
+    for (unsigned int i = 0; i < corpus.boards.size(); i++)
+    {
+        Board& board = corpus.boards[i];
+        vector<StepCombo>& moves = corpus.moves[i];
+        for (unsigned int j = 0; j < moves.size(); j++)
+        {
+            Step step = moves[j].steps[0];
+            board.playStep(step);
+            corpus.sink += board.hash;
+            board.undoStep(step);
+        }
+        numOps += moves.size();
+    }
+    return numOps;
+}
+
+Int64 benchGenMoves(MicroBenchCorpus& corpus)
+{
+    static vector<StepCombo> combos;
+    for (unsigned int i = 0; i < corpus.boards.size(); i++)
+    {
+        combos.clear();
+        corpus.sink += corpus.boards[i].genMoves(combos);
+    }
+    return corpus.boards.size();
+}
+
+Int64 benchGenDependentMoves(MicroBenchCorpus& corpus)
+{
+    static vector<StepCombo> combos;
+    for (unsigned int i = 0; i < corpus.dependentBoards.size(); i++)
+    {
+        combos.clear();
+        corpus.sink += corpus.dependentBoards[i].genDependentMoves(combos,
+                                                corpus.dependentMoves[i]);
+    }
+    return corpus.dependentBoards.size();
+}
+
+Int64 benchGen2Step(MicroBenchCorpus& corpus)
+{
+    Int64 numOps = 0;
+    StepCombo combo;
+    for (unsigned int i = 0; i < corpus.boards.size(); i++)
+    {
+        Board& board = corpus.boards[i];
+        vector<StepCombo>& moves = corpus.moves[i];
+        for (unsigned int j = 0; j < moves.size(); j++)
+        {
+            if (moves[j].stepCost != 2 || moves[j].numSteps < 2)
+                continue;
+
+            combo.reset();
+            corpus.sink += board.gen2Step(combo, moves[j].steps[0].getFrom(),
+                                          moves[j].steps[0].getTo(),
+                                          moves[j].steps[1].getFrom());
+            numOps++;
+        }
+    }
+    return numOps;
+}
+
+Int64 benchIsFrozen(MicroBenchCorpus& corpus)
+{
+    Int64 numOps = 0;
+    for (unsigned int i = 0; i < corpus.boards.size(); i++)
+    {
+        Board& board = corpus.boards[i];
+        vector<unsigned char>& squares = corpus.squares[i];
+        vector<unsigned char>& pieces = corpus.pieces[i];
+        for (unsigned int j = 0; j < squares.size(); j++)
+            corpus.sink += board.isFrozen(squares[j], pieces[j]);
+        numOps += squares.size();
+    }
+    return numOps;
+}
+
+Int64 benchEvalMiss(MicroBenchCorpus& corpus)
+{
+    for (unsigned int i = 0; i < corpus.boards.size(); i++)
+        corpus.sink += corpus.evalMiss.evalBoard(corpus.boards[i], GOLD);
+    return corpus.boards.size();
+}
+
+Int64 benchEvalHit(MicroBenchCorpus& corpus)
+{
+    for (unsigned int i = 0; i < corpus.boards.size(); i++)
+        corpus.sink += corpus.evalHit.evalBoard(corpus.boards[i], GOLD);
+    return corpus.boards.size();
+}
+
+Int64 benchTransProbe(MicroBenchCorpus& corpus)
+{
+    unsigned int first = corpus.nextKey;
+    corpus.nextKey = (first + MICROBENCH_KEYS_PER_PASS) % corpus.keys.size();
+    for (unsigned int i = first; i < first + MICROBENCH_KEYS_PER_PASS; i++)
+        corpus.sink += corpus.transTable.hasValidEntry(corpus.keys[i]);
+    return MICROBENCH_KEYS_PER_PASS;
+}
+
+Int64 benchEvalHashProbe(MicroBenchCorpus& corpus)
+{
+    EvalHashEntry entry;
+    unsigned int first = corpus.nextKey;
+    corpus.nextKey = (first + MICROBENCH_KEYS_PER_PASS) % corpus.keys.size();
+    for (unsigned int i = first; i < first + MICROBENCH_KEYS_PER_PASS; i++)
+        corpus.sink += corpus.evalHit.hashTable.getEntry(corpus.keys[i],
+                                                          entry);
+    return MICROBENCH_KEYS_PER_PASS;
+}
+
+//The heap works on the moves in place, so it needs a copy of each list to
+//order. The cost of the copy alone is timed too.
+Int64 benchCopyMoves(MicroBenchCorpus& corpus)
+{
+    static vector<StepCombo> work;
+    for (unsigned int i = 0; i < corpus.moves.size(); i++)
+    {
+        work = corpus.moves[i];
+        corpus.sink += work.back().score;
+    }
+    return corpus.moves.size();
+}
+
+//Orders the moves of each list with the heap, picking the number of moves
+//given from each, or all of them if 0
+static Int64 orderWithHeap(MicroBenchCorpus& corpus, unsigned int numPicks)
+{
+    static vector<StepCombo> work;
+    for (unsigned int i = 0; i < corpus.moves.size(); i++)
+    {
+        work = corpus.moves[i];
+        maxHeapCreate(work);
+        for (unsigned int j = 0; !work.empty() &&
+                                 (numPicks == 0 || j < numPicks); j++)
+            corpus.sink += maxHeapGetTopAndRemove(work).score;
+    }
+    return corpus.moves.size();
+}
+
+//Orders the moves of each list with the move picker, the same way
+static Int64 orderWithPicker(MicroBenchCorpus& corpus, unsigned int numPicks)
+{
+    static MovePicker picker;
+    for (unsigned int i = 0; i < corpus.moves.size(); i++)
+    {
+        vector<StepCombo>& moves = corpus.moves[i];
+        picker.init(moves);
+        for (unsigned int j = 0; !picker.empty() &&
+                                 (numPicks == 0 || j < numPicks); j++)
+            corpus.sink += moves[picker.pickNext()].score;
+    }
+    return corpus.moves.size();
+}
+
+Int64 benchHeapAll(MicroBenchCorpus& corpus)
+{
+    return orderWithHeap(corpus, 0);
+}
+
+Int64 benchHeapEarly(MicroBenchCorpus& corpus)
+{
+    return orderWithHeap(corpus, MICROBENCH_EARLY_PICKS);
+}
+
+Int64 benchPickerAll(MicroBenchCorpus& corpus)
+{
+    return orderWithPicker(corpus, 0);
+}
+
+Int64 benchPickerEarly(MicroBenchCorpus& corpus)
+{
+    return orderWithPicker(corpus, MICROBENCH_EARLY_PICKS);
+}
+
+//A primitive to time, run over the whole corpus
+class MicroBenchmark
+{
+    public:
+    const char* name;
+    Int64 (*run)(MicroBenchCorpus& corpus);
+};
+
+static MicroBenchmark benchmarks[] =
+{
+    {"playStep+undoStep",    benchPlayUndoStep},
+    {"genMoves",             benchGenMoves},
+    {"genDependentMoves",    benchGenDependentMoves},
+    {"gen2Step",             benchGen2Step},
+    {"isFrozen",             benchIsFrozen},
+    {"evalBoard hash miss",  benchEvalMiss},
+    {"evalBoard hash hit",   benchEvalHit},
+    {"trans table probe",    benchTransProbe},
+    {"eval hash probe",      benchEvalHashProbe},
+    {"copy move list",       benchCopyMoves},
+    {"heap order all",       benchHeapAll},
+    {"heap order first 3",   benchHeapEarly},
+    {"picker order all",     benchPickerAll},
+    {"picker order first 3", benchPickerEarly}
+};
+
+int main(int argc, char * args[])
+{
+    try
+    {
+        //initialize the 64 bit arrays
+        initInt64();
+        srand(0);
+
+        int numWarmup = 20;
+        int numReps = 200;
+        string filter;
+        string evalWeightFile = string("evalWeights/weights.txt");
+
+        for (int i = 1; i < argc; ++i)
+        {
+            if (string(args[i]) == string("--warmup") && i + 1 < argc)
+                numWarmup = atoi(args[++i]);
+            else if (string(args[i]) == string("--reps") && i + 1 < argc)
+                numReps = atoi(args[++i]);
+            else if (string(args[i]) == string("--filter") && i + 1 < argc)
+                filter = args[++i];
+            else if (string(args[i]) == string("--weights") && i + 1 < argc)
+                evalWeightFile = args[++i];
+            else
+            {
+                cout << "Jr Arimaa Bot microbenchmarks\n";
+                cout << "Usage: microbench [flags]\n\n";
+                cout << "Times board, eval and hash table primitives over"
+                     << " a corpus of positions.\nEach sample is one pass"
+                     << " over the corpus, and the time per call is given"
+                     << "\nfor the median, 99th percentile and fastest"
+                     << " sample.\n\n";
+                cout << "Flags:\n\n";
+                cout << "--warmup num\nUntimed passes before the samples."
+                     << " Defaults to 20\n\n";
+                cout << "--reps num\nNumber of samples. Defaults to"
+                     << " 200\n\n";
+                cout << "--filter text\nOnly runs the primitives with the"
+                     << " text in their name\n\n";
+                cout << "--weights weightFile\nEval weight file. Defaults"
+                     << " to evalWeights/weights.txt\n\n";
+                return 0;
+            }
+        }
+
+        if (numReps < 1)
+            numReps = 1;
+
+        MicroBenchCorpus corpus;
+        buildCorpus(corpus, evalWeightFile);
+        cout << "Corpus of " << corpus.boards.size() << " positions, "
+             << corpus.dependentBoards.size() << " after one step, "
+             << corpus.keys.size() << " random keys\n\n";
+
+        cout << setw(22) << left << "Primitive" << right
+             << setw(10) << "Calls" << setw(12) << "Median ns"
+             << setw(12) << "p99 ns" << setw(12) << "Min ns"
+             << setw(12) << "Mean ns" << "\n";
+
+        int numBenchmarks = sizeof(benchmarks) / sizeof(benchmarks[0]);
+        for (int b = 0; b < numBenchmarks; b++)
+        {
+            MicroBenchmark& benchmark = benchmarks[b];
+            if (string(benchmark.name).find(filter) == string::npos)
+                continue;
+
+            for (int i = 0; i < numWarmup; i++)
+                benchmark.run(corpus);
+
+            //time per call of each sample
+            vector<double> samples;
+            Int64 numCalls = 0;
+            for (int i = 0; i < numReps; i++)
+            {
+                chrono::steady_clock::time_point start =
+                                             chrono::steady_clock::now();
+                numCalls = benchmark.run(corpus);
+                double nanos = chrono::duration<double, nano>(
+                               chrono::steady_clock::now() - start).count();
+
+                samples.push_back(nanos / (numCalls > 0 ? numCalls : 1));
+            }
+
+            sort(samples.begin(), samples.end());
+            double mean = 0;
+            for (unsigned int i = 0; i < samples.size(); i++)
+                mean += samples[i];
+            mean /= samples.size();
+
+            //nearest rank percentile
+            unsigned int p99 = (samples.size() * 99 + 99) / 100 - 1;
+
+            cout << setw(22) << left << benchmark.name << right
+                 << setw(10) << numCalls << fixed << setprecision(1)
+                 << setw(12) << samples[samples.size() / 2]
+                 << setw(12) << samples[p99]
+                 << setw(12) << samples[0]
+                 << setw(12) << mean << "\n";
+            cout.unsetf(ios::fixed);
+            cout << setprecision(6);
+        }
+
+        //keeps the results used
+        cout << "\nChecksum " << hex << corpus.sink << dec << endl;
+    }
+
+    catch (Error error)
+    {
+        cerr << "Caught Error: \n"
+             << error << endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,95 @@
+#ifndef __JR_MOVEPICKER_H__
+#define __JR_MOVEPICKER_H__
+
+//Picking of moves in order of their move ordering scores, without moving
+//the moves themselves
+
+#include "step.h"
+#include <algorithm>
+#include <vector>
+
+//number of moves picked by finding the highest key before the rest of the
+//keys are sorted, as most nodes that are cut off are cut off by one of the
+//first few moves
+#define MOVE_PICKER_SELECTIONS 3
+
+using namespace std;
+
+//Gives the indices of a list of moves from the highest score to the lowest,
+//one at a time. Only a key of the score and index of each move is kept.
+//The first few moves are picked by finding the highest remaining key, so a
+//node that is cut off early doesn't pay for ordering the rest, and the keys
+//left after those are sorted once. The keys are kept between uses, so once
+//the picker of a ply has held the most moves it will see, it doesn't
+//allocate memory again.
+class MovePicker
+{
+    public:
+    MovePicker()
+    {
+        numLeft = 0;
+        numPicked = 0;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //Starts picking from the moves given, using the score of each. Moves
+    //with the same score are picked in the order they are in.
+    //////////////////////////////////////////////////////////////////////////
+    void init(vector<StepCombo>& combos)
+    {
+        keys.resize(combos.size());
+        for (unsigned int i = 0; i < combos.size(); i++)
+            keys[i] = combos[i].score * 65536 + (65535 - (int)i);
+        numLeft = combos.size();
+        numPicked = 0;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //Returns true if every move has been picked
+    //////////////////////////////////////////////////////////////////////////
+    bool empty()
+    {
+        return numLeft == 0;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //Returns the index of the move with the highest score that hasn't been
+    //picked yet, and removes it from the moves left
+    //////////////////////////////////////////////////////////////////////////
+    unsigned int pickNext()
+    {
+        int key;
+        if (numPicked < MOVE_PICKER_SELECTIONS)
+        {
+            unsigned int best = 0;
+            for (unsigned int i = 1; i < numLeft; i++)
+            {
+                if (keys[i] > keys[best])
+                    best = i;
+            }
+
+            key = keys[best];
+            keys[best] = keys[--numLeft];
+        }
+        else
+        {
+            //sort the rest so the highest key is last, and take them from
+            //the end
+            if (numPicked == MOVE_PICKER_SELECTIONS)
+                sort(keys.begin(), keys.begin() + numLeft);
+            key = keys[--numLeft];
+        }
+
+        numPicked++;
+        return 65535 - (key & 65535);
+    }
+
+    private:
+    vector<int> keys;     //score of each move in the upper 16 bits, and
+                          //65535 less its index in the lower 16, so the
+                          //highest key is the move to pick next
+    unsigned int numLeft;   //number of keys not picked yet
+    unsigned int numPicked; //number of keys picked so far
+};
+
+#endif
@@ -0,0 +1,79 @@
+#include "profile.h"
+
+#ifdef SEARCH_PROFILE
+
+#include "int64.h"
+#include <iomanip>
+#include <iostream>
+
+using namespace std;
+
+thread_local ProfileCounter profileCounters[PROFILE_NUM_PHASES];
+
+//ticks when the counters were last reset
+static thread_local Int64 profileStart;
+
+//names of the parts of the search, in the order of the counters
+static const char* profileNames[PROFILE_NUM_PHASES] =
+{
+    "genMoves", "genDependentMoves", "genTacticalMoves", "evalBoard",
+    "scoreCombos", "order moves", "trans table probe", "playCombo",
+    "undoCombo"
+};
+
+//////////////////////////////////////////////////////////////////////////////
+//Sets every counter of this thread back to zero, and starts timing the
+//total from now
+//////////////////////////////////////////////////////////////////////////////
+void profileReset()
+{
+    for (int i = 0; i < PROFILE_NUM_PHASES; i++)
+    {
+        profileCounters[i].calls = 0;
+        profileCounters[i].ticks = 0;
+    }
+    profileStart = profileTicks();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Writes the calls, time, time per call and share of the total time of each
+//part of the search since the last reset. The seconds given are the time
+//since the reset, which converts ticks to time.
+//////////////////////////////////////////////////////////////////////////////
+void profileReport(ostream& log, double seconds)
+{
+    Int64 totalTicks = profileTicks() - profileStart;
+    if (totalTicks == 0)
+        totalTicks = 1;
+    double secondsPerTick = seconds / totalTicks;
+
+    log << "Search profile:\n";
+    log << setw(20) << "Part" << setw(12) << "Calls" << setw(12)
+        << "Time(ms)" << setw(10) << "ns/call" << setw(8) << "Share\n";
+
+    Int64 timedTicks = 0;
+    for (int i = 0; i < PROFILE_NUM_PHASES; i++)
+    {
+        ProfileCounter& counter = profileCounters[i];
+        timedTicks += counter.ticks;
+
+        log << setw(20) << profileNames[i] << setw(12) << counter.calls
+            << fixed << setprecision(1) << setw(12)
+            << counter.ticks * secondsPerTick * 1000 << setw(10)
+            << (counter.calls > 0 ? counter.ticks * secondsPerTick * 1e9
+                                    / counter.calls : 0)
+            << setw(7) << 100.0 * counter.ticks / totalTicks << "%\n";
+    }
+
+    //the rest of the time is spent in the search itself
+    Int64 restTicks = totalTicks > timedTicks ? totalTicks - timedTicks : 0;
+    log << setw(20) << "rest" << setw(12) << "" << setw(12)
+        << restTicks * secondsPerTick * 1000 << setw(10) << ""
+        << setw(7) << 100.0 * restTicks / totalTicks << "%\n";
+
+    log.unsetf(ios::fixed);
+    log << setprecision(6);
+    log.flush();
+}
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef __JR_PROFILE_H__
+#define __JR_PROFILE_H__
+
+//Counters of the calls and time spent in each part of the search. They are
+//only compiled in when SEARCH_PROFILE is defined, for example with
+//"make clean; make EXTRAFLAGS=-DSEARCH_PROFILE", and cost nothing
+//otherwise. The counters are per thread, so searches on different threads
+//don't mix.
+
+#include "int64.h"
+#include <iostream>
+
+//parts of the search that are timed
+#define PROFILE_GEN_MOVES     0 //generating all moves
+#define PROFILE_GEN_DEPENDENT 1 //generating moves dependent on the last one
+#define PROFILE_GEN_TACTICAL  2 //generating captures and goals
+#define PROFILE_EVAL          3 //evaluating a position
+#define PROFILE_SCORE_COMBOS  4 //scoring moves for ordering
+#define PROFILE_ORDER_MOVES   5 //setting up the order to search moves in
+#define PROFILE_TRANS_PROBE   6 //looking up the transposition table
+#define PROFILE_PLAY          7 //playing a move
+#define PROFILE_UNDO          8 //taking back a move
+#define PROFILE_NUM_PHASES    9
+
+using namespace std;
+
+#ifdef SEARCH_PROFILE
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+//Calls and ticks spent in one part of the search
+class ProfileCounter
+{
+    public:
+    Int64 calls; //number of times the part was timed
+    Int64 ticks; //ticks spent in it
+};
+
+extern thread_local ProfileCounter profileCounters[PROFILE_NUM_PHASES];
+
+//////////////////////////////////////////////////////////////////////////////
+//Returns the current time in ticks, which are cpu cycles where the time
+//stamp counter can be read and nanoseconds otherwise
+//////////////////////////////////////////////////////////////////////////////
+inline Int64 profileTicks()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return chrono::duration_cast<chrono::nanoseconds>(
+           chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+//Times one part of the search from its construction to its destruction
+class ProfileTimer
+{
+    public:
+    ProfileTimer(int phase)
+    {
+        this->phase = phase;
+        start = profileTicks();
+    }
+
+    ~ProfileTimer()
+    {
+        profileCounters[phase].calls++;
+        profileCounters[phase].ticks += profileTicks() - start;
+    }
+
+    private:
+    int phase;   //part of the search being timed
+    Int64 start; //ticks when the timer was made
+};
+
+void profileReset();
+void profileReport(ostream& log, double seconds);
+
+//times the expression as a part of the search, and gives its value
+#define PROFILE_CALL(phase, expr) (ProfileTimer(phase), (expr))
+
+#else
+
+inline void profileReset()
+{
+}
+
+inline void profileReport(ostream&, double)
+{
+}
+
+#define PROFILE_CALL(phase, expr) (expr)
+
+#endif
+
+#endif
@@ -5,8 +5,16 @@
 #include "piece.h"
 #include "square.h"
 #include "eval.h"
-#include "maxheap.h"
+#include "movepicker.h"
+#include "profile.h"
+#include "hashmem.h"
+#include "telemetry.h"
+#include "textfile.h"
+#include "treelog.h"
+#include <chrono>
+#include <ctype.h>
 #include <fstream>
+#include <stdio.h>
 #include <time.h>
 #include <string.h>
 #include <sstream>
@@ -16,30 +24,55 @@
 
 using namespace std;
 
+//move recorded in the tree log for nodes without one
+static const RawMove noTreeMove(0, ILLEGAL_SQUARE, ILLEGAL_SQUARE,
+                                ILLEGAL_SQUARE);
+
 //////////////////////////////////////////////////////////////////////////////
 //Constructor. Basically set last search mode to none and initialize the 
-//hash tables to the specified size
+//hash tables. Each table can be given its own size in bytes, and the tables
+//given a size of 0 share the rest of the total hash table memory evenly.
 //////////////////////////////////////////////////////////////////////////////
-Search :: Search(Int64 hashTableSize)
+Search :: Search(Int64 hashTableBytes, Int64 transTableBytes,
+                 Int64 searchHistBytes, Int64 evalHashBytes)
 {
-    //Initialize hash tables and spread the memory evenly
-    int tableSize = hashTableSize / 3;
-
-    int transTableBits = 0, searchHistTableBits = 0, evalHashBits = 0;
-    for (; Int64FromIndex(transTableBits) * sizeof(TranspositionEntry)
-           <= tableSize; transTableBits++);
-    for (; Int64FromIndex(searchHistTableBits) * sizeof(SearchHistEntry)
-           <= tableSize; searchHistTableBits++);
-    for (; Int64FromIndex(evalHashBits) * sizeof(EvalHashEntry)
-           <= tableSize; evalHashBits++);
-
-    transTable.setHashKeySize(transTableBits - 1);
-    searchHistTable.setHashKeySize(searchHistTableBits - 1);
-    eval.hashTable.setHashKeySize(evalHashBits - 1);
-
-    //Keep the game history table some preset size, as the program will
-    //not behave properly at all if this table is too small
-    gameHistTable.setHashKeySize(GAME_HIST_HASH_BITS);
+    Int64 tableBytes[3] = {transTableBytes, searchHistBytes, evalHashBytes};
+    Int64 bytesLeft = hashTableBytes;
+    int numUnsized = 0;
+
+    for (int i = 0; i < 3; i++)
+    {
+        if (tableBytes[i] == 0)
+            numUnsized++;
+        else if (tableBytes[i] < bytesLeft)
+            bytesLeft -= tableBytes[i];
+        else
+            bytesLeft = 0;
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        if (tableBytes[i] == 0)
+            tableBytes[i] = bytesLeft / numUnsized;
+    }
+
+    //The tables can be any size, so they use all of their memory, but they
+    //always need at least one entry
+    Int64 transEntries       = tableBytes[0] / sizeof(TranspositionEntry);
+    Int64 searchHistEntries  = tableBytes[1] / sizeof(SearchHistEntry);
+    Int64 evalHashEntries    = tableBytes[2] / sizeof(EvalHashEntry);
+
+    transTable.setNumEntries(transEntries > 0 ? transEntries : 1);
+    searchHistTable.setNumEntries(searchHistEntries > 0 ? 
+                                  searchHistEntries : 1);
+    eval.hashTable.setNumEntries(evalHashEntries > 0 ? evalHashEntries : 1);
+
+    quiesceNodeBudget = SEARCH_QUIESCE_NODE_BUDGET;
+    maxNodes = 0;
+    maxSeconds = 0;
+    telemetry = 0;
+    treeLog = 0;
+    keepTables = false;
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -50,6 +83,27 @@ Search :: ~Search()
 
 }
 
+//////////////////////////////////////////////////////////////////////////////
+//Adds the fields every telemetry record of a search has, with the stats of
+//the search so far and the time taken so far
+//////////////////////////////////////////////////////////////////////////////
+static void addSearchStats(TelemetryRecord& record, Search& search,
+                           double seconds)
+{
+    record.add("nodes", search.numTotalNodes);
+    record.add("terminal_nodes", search.numTerminalNodes);
+    record.add("ms", (Int64)(seconds * 1000));
+    record.add("nps", (Int64)(seconds > 0 ? search.numTotalNodes / seconds
+                                           : 0));
+    record.add("tt_probes", search.transProbes);
+    record.add("tt_hits", search.transHits);
+    record.add("tt_cutoffs", search.hashHits);
+    record.add("eval_hit_rate", search.eval.numLookups > 0 ?
+               (double)search.eval.numHashHits / search.eval.numLookups : 0);
+    record.add("first_move_cutoff_ratio", search.numCutoffs > 0 ?
+               (double)search.numFirstMoveCutoffs / search.numCutoffs : 0);
+}
+
 //////////////////////////////////////////////////////////////////////////////
 //Resets all relevant search stats and does an iterative deepening search
 //and returns the best move
@@ -60,9 +114,20 @@ StepCombo Search :: iterativeDeepen(Board& board, int maxDepth, ostream& log)
     numTerminalNodes = 0;
     numTotalNodes = 0;
     hashHits = 0;
+    transProbes = 0;
+    transHits = 0;
+    numCutoffs = 0;
+    numFirstMoveCutoffs = 0;
+    eval.numLookups = 0;
+    eval.numHashHits = 0;
     
-    eval.reset();
-    transTable.reset();
+    //Start with clean tables, unless they were just loaded from a snapshot
+    if (!keepTables)
+    {
+        eval.reset();
+        transTable.reset();
+    }
+    keepTables = false;
     searchHistTable.reset();
     searchHistTable.setOccur(board.hashPiecesOnly, 0, board.sideToMove);
 
@@ -71,18 +136,33 @@ StepCombo Search :: iterativeDeepen(Board& board, int maxDepth, ostream& log)
         << "Nodes/Sec" << " PV\n";
     //start timing now
     time_t reftime = clock();
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    profileReset();
 
     vector<string> pv;
 
+    if (treeLog)
+        treeLog->start(board, 4 - board.stepsLeft);
+
+    //nodes of the last two iterations, for the branching factor
+    unsigned int lastNodes = 0;
+    double branchingFactor = 0;
+    int depthDone = 0;
+
     for (int currDepth = 1; currDepth <= maxDepth; currDepth++)
     {
+        unsigned int nodesBefore = numTotalNodes;
         StepCombo pass;
         pass.genPass(board.stepsLeft);
-        pass.evalScore = eval.evalBoard(board, board.sideToMove);
+        pass.evalScore = PROFILE_CALL(PROFILE_EVAL,
+                             eval.evalBoard(board, board.sideToMove));
+        numQuiesceNodes = 0;
         short score = searchNode(board, currDepth, 4 - board.stepsLeft,
                                  -30000, 30000, pv, pass, false,
                                  board.hashPiecesOnly);
         
+        rootScore = score;
+
         Int64 currMillis = (clock() - reftime) * 1000 / CLOCKS_PER_SEC + 1; 
         log << setw(6) << currDepth << setw(6) << score << setw(15) 
             << numTotalNodes << setw(10) << currMillis << setw(10)
@@ -93,10 +173,44 @@ StepCombo Search :: iterativeDeepen(Board& board, int maxDepth, ostream& log)
 
         log.flush();
 
+        //the branching factor is how many times more nodes this iteration
+        //took than the last one
+        depthDone = currDepth;
+        unsigned int iterationNodes = numTotalNodes - nodesBefore;
+        if (lastNodes > 0)
+            branchingFactor = (double)iterationNodes / lastNodes;
+        lastNodes = iterationNodes;
+
+        if (treeLog)
+            treeLog->addIteration(currDepth, score, numTotalNodes);
+
+        if (telemetry)
+        {
+            TelemetryRecord record("iteration");
+            record.add("turn", board.turnNumber);
+            record.add("side", string(1, charFromColor(board.sideToMove)));
+            record.add("depth", currDepth);
+            record.add("score", (int)score);
+            addSearchStats(record, *this, chrono::duration<double>(
+                           chrono::steady_clock::now() - start).count());
+            record.add("iteration_nodes", iterationNodes);
+            record.add("quiesce_nodes", numQuiesceNodes);
+            record.add("branching_factor", branchingFactor);
+            record.add("pv", pv);
+            record.write(*telemetry);
+        }
+
         //If the score is so great, then it's probably a win, so don't
         //search any further
         if (score >= 20000)
             break;
+
+        //stop deepening once the nodes or time run out
+        if ((maxNodes > 0 && numTotalNodes >= maxNodes) ||
+            (maxSeconds > 0 && chrono::duration<double>(
+                               chrono::steady_clock::now() - start).count()
+                               >= maxSeconds))
+            break;
     }
 
     //extract current turn from pv
@@ -115,6 +229,24 @@ StepCombo Search :: iterativeDeepen(Board& board, int maxDepth, ostream& log)
         PVToPlay.addCombo(steps);
     }
 
+    profileReport(log, chrono::duration<double>(
+                       chrono::steady_clock::now() - start).count());
+
+    if (telemetry)
+    {
+        TelemetryRecord record("move");
+        record.add("turn", board.turnNumber);
+        record.add("side", string(1, charFromColor(board.sideToMove)));
+        record.add("move", PVToPlay.toString());
+        record.add("depth", depthDone);
+        record.add("score", (int)rootScore);
+        addSearchStats(record, *this, chrono::duration<double>(
+                       chrono::steady_clock::now() - start).count());
+        record.add("branching_factor", branchingFactor);
+        record.add("pv", pv);
+        record.write(*telemetry);
+    }
+
     return PVToPlay;
 }    
 
@@ -131,26 +263,36 @@ short Search :: searchNode(Board& board, int depth, int ply, short alpha,
 {   
     ++numTotalNodes; //count the node as explored
 
+    //the node's id and window, for the tree log
+    unsigned int nodeId = numTotalNodes;
+    short alphaIn = alpha;
+    short betaIn = beta;
+    if (treeLog)
+        treeLog->enterNode(ply, nodeId);
+
     //check if this is a winning position
     if (eval.isWin(board, board.sideToMove)) 
     {
         ++numTerminalNodes; //node is terminal
 
+        if (treeLog)
+            treeLog->addNode(nodeId, board.hash, ply, depth, alphaIn, betaIn,
+                             beta, TREE_NODE_WIN, noTreeMove);
         return beta; //return positive infinity.
     }
 
     if (depth <= 0) //terminal node due to depth
     {
         ++numTerminalNodes; //this node is terminal
-        //Get the evaluated score, which is stored as the lastMove's score
-        //But make sure it is within the alpha-beta window
-        if (lastMove.evalScore < alpha)  
-            return alpha;
-        
-        if (lastMove.evalScore > beta)
-            return beta;
 
-        return lastMove.evalScore;
+        //Get the evaluated score, but extend the search with only captures
+        //and goals so that tactics just past the horizon are not missed
+        short score = quiesceNode(board, SEARCH_QUIESCE_MAX_STEPS, ply,
+                                  alpha, beta, lastMove, turnRefer);
+        if (treeLog)
+            treeLog->addNode(nodeId, board.hash, ply, depth, alphaIn, betaIn,
+                             score, TREE_NODE_HORIZON, noTreeMove);
+        return score;
     }
 
     //Check if the player has the last move, if the position is already
@@ -159,7 +301,12 @@ short Search :: searchNode(Board& board, int depth, int ply, short alpha,
     //handle passes), this position will lead to a beta cutoff no matter
     //what.
     if (depth <= board.stepsLeft && lastMove.evalScore >= beta)
+    {
+        if (treeLog)
+            treeLog->addNode(nodeId, board.hash, ply, depth, alphaIn, betaIn,
+                             beta, TREE_NODE_STAND_PAT, noTreeMove);
         return beta;
+    }
 
     //make sure to just pass here if there are no steps left, this can only
     //occur if the root node started with no steps left.
@@ -167,17 +314,26 @@ short Search :: searchNode(Board& board, int depth, int ply, short alpha,
     {
         StepCombo pass;
         pass.genPass(0);
-        pass.evalScore = eval.evalBoard(board, board.sideToMove);
-        return doMoveAndSearch(board, depth, ply, alpha, beta, nodePV, pass,
-                               pass.evalScore, turnRefer);
+        pass.evalScore = PROFILE_CALL(PROFILE_EVAL,
+                             eval.evalBoard(board, board.sideToMove));
+        short score = doMoveAndSearch(board, depth, ply, alpha, beta,
+                                      nodePV, pass, pass.evalScore,
+                                      turnRefer);
+        if (treeLog)
+            treeLog->addNode(nodeId, board.hash, ply, depth, alphaIn, betaIn,
+                             score, TREE_NODE_PASS, noTreeMove);
+        return score;
     }
 
     //list of moves to try before generating all the moves
     vector<StepCombo> preGenSteps;
 
     //check if there is a hash position of at least this depth
-    if (transTable.hasValidEntry(board.hash))
+    ++transProbes;
+    if (PROFILE_CALL(PROFILE_TRANS_PROBE,
+                     transTable.hasValidEntry(board.hash)))
     {
+        ++transHits;
         TranspositionEntry thisEntry = transTable.getEntry(board.hash);  
 
         //adjust the bounds with the bounds in the hash entry, if the depth 
@@ -221,6 +377,15 @@ short Search :: searchNode(Board& board, int depth, int ply, short alpha,
                 nodePV[0] = "<HT>";
                 hashHits++;
                 ++numTerminalNodes;
+                if (treeLog)
+                {
+                    treeLog->addNode(nodeId, board.hash, ply, depth, alphaIn,
+                                     betaIn, cutScore, TREE_NODE_TT_CUTOFF,
+                                     RawMove(thisEntry.getNumSteps(),
+                                             thisEntry.getFrom1(),
+                                             thisEntry.getTo1(),
+                                             thisEntry.getFrom2()));
+                }
                 return cutScore;
             }
         }
@@ -245,6 +410,7 @@ short Search :: searchNode(Board& board, int depth, int ply, short alpha,
 
     short oldAlpha = alpha;
     StepCombo bestCombo;
+    int numTried = 0; //moves searched so far
 
     //if there are any pre-gen steps, explore them first
     if (preGenSteps.size() > 0) 
@@ -258,6 +424,7 @@ short Search :: searchNode(Board& board, int depth, int ply, short alpha,
             short nodeScore = doMoveAndSearch(board, depth, ply, alpha, 
                                               beta, nodePV, next,
                                               lastMove.evalScore, turnRefer);
+            ++numTried;
 
             if (nodeScore > alpha) 
             {   
@@ -265,6 +432,10 @@ short Search :: searchNode(Board& board, int depth, int ply, short alpha,
                 alpha = nodeScore;
                 if (nodeScore >= beta) //beta cutoff
                 {   
+                    ++numCutoffs;
+                    if (numTried == 1)
+                        ++numFirstMoveCutoffs;
+
                     //Store the hash for this position and note a beta
                     //cutoff, that is: note that beta is a lower bound
                     transTable.setEntry(board.hash, 
@@ -274,6 +445,11 @@ short Search :: searchNode(Board& board, int depth, int ply, short alpha,
                     //increase history score
                     eval.histTable.increaseScore(next.getRawMove(), 
                                                  board.sideToMove, depth);
+                    if (treeLog)
+                        treeLog->addNode(nodeId, board.hash, ply, depth,
+                                         alphaIn, betaIn, beta,
+                                         TREE_NODE_BETA_CUT,
+                                         next.getRawMove());
                     return beta;
                 }
             }
@@ -306,17 +482,21 @@ short Search :: searchNode(Board& board, int depth, int ply, short alpha,
     if ((ply % 4 == 1 || genDependent) && lastMove.numSteps > 0)
     {
         combos[ply].clear();
-        board.genDependentMoves(combos[ply], lastMove);
+        PROFILE_CALL(PROFILE_GEN_DEPENDENT,
+                     board.genDependentMoves(combos[ply], lastMove));
     }
     else
     {
         combos[ply].clear();
-        board.genMoves(combos[ply]);
+        PROFILE_CALL(PROFILE_GEN_MOVES, board.genMoves(combos[ply]));
     }
         
     if (combos[ply].size() == 0 ) 
     {
         //loss by immobility
+        if (treeLog)
+            treeLog->addNode(nodeId, board.hash, ply, depth, alphaIn, betaIn,
+                             alpha, TREE_NODE_NO_MOVES, noTreeMove);
         return alpha;
     }
 
@@ -341,22 +521,26 @@ short Search :: searchNode(Board& board, int depth, int ply, short alpha,
     }
 
     //score the combos for sorting
-    eval.scoreCombos(combos[ply], board.sideToMove); 
+    PROFILE_CALL(PROFILE_SCORE_COMBOS,
+                 eval.scoreCombos(combos[ply], board.sideToMove));
 
-    //max heapify the array, in order to implement a priority queue based
-    //on score
-    maxHeapCreate(combos[ply]);
+    //pick the combos in order of score. The picker is looked up again for
+    //each combo, as searching the subtree can grow the pickers.
+    if ((int)pickers.size() - 1 < (int)ply)
+        pickers.resize(ply + 1);
+    PROFILE_CALL(PROFILE_ORDER_MOVES, pickers[ply].init(combos[ply]));
 
     //play each step, and explore each subtree
-    while (!combos[ply].empty())
+    while (!pickers[ply].empty())
     {
         //get the next combo to look at.
-        StepCombo next = maxHeapGetTopAndRemove(combos[ply]);
+        StepCombo next = combos[ply][pickers[ply].pickNext()];
 
         //explore the subtree for this move.
         short nodeScore = doMoveAndSearch(board, depth, ply, alpha, beta, 
                                           nodePV, next, lastMove.evalScore,
                                           turnRefer);
+        ++numTried;
             
         if (nodeScore > alpha) 
         {   
@@ -364,6 +548,10 @@ short Search :: searchNode(Board& board, int depth, int ply, short alpha,
             alpha = nodeScore;
             if (nodeScore >= beta) //beta cutoff
             {   
+                ++numCutoffs;
+                if (numTried == 1)
+                    ++numFirstMoveCutoffs;
+
                 //Store the hash for this position and note a beta
                 //cutoff, that is: note that beta is a lower bound
                 transTable.setEntry(board.hash, 
@@ -373,6 +561,10 @@ short Search :: searchNode(Board& board, int depth, int ply, short alpha,
                 //increase history score
                 eval.histTable.increaseScore(next.getRawMove(), 
                                              board.sideToMove, depth);
+                if (treeLog)
+                    treeLog->addNode(nodeId, board.hash, ply, depth, alphaIn,
+                                     betaIn, beta, TREE_NODE_BETA_CUT,
+                                     next.getRawMove());
                 return beta;
             }
         }
@@ -397,6 +589,12 @@ short Search :: searchNode(Board& board, int depth, int ply, short alpha,
         eval.histTable.increaseScore(bestCombo.getRawMove(), board.sideToMove, 
                                      depth);
     }
+
+    if (treeLog)
+        treeLog->addNode(nodeId, board.hash, ply, depth, alphaIn, betaIn,
+                         alpha, oldAlpha == alpha ? TREE_NODE_FAIL_LOW
+                                                  : TREE_NODE_EXACT,
+                         bestCombo.getRawMove());
         
     return alpha;
 }
@@ -411,13 +609,26 @@ short Search :: doMoveAndSearch(Board& board, int depth, int ply, short alpha,
                                 Int64 turnRefer)
 {
     
-    board.playCombo(combo);  
+    PROFILE_CALL(PROFILE_PLAY, board.playCombo(combo));
+
+    //All the keys for the child node are known now, so start loading its
+    //table entries while the checks below are done. The child is searched
+    //after the turn change if there are no steps left.
+    searchHistTable.prefetch(board.hashPiecesOnly);
+    eval.hashTable.prefetch(board.hashPiecesOnly);
+    if (board.stepsLeft != 0)
+        transTable.prefetch(board.hash);
+    else
+        transTable.prefetch(board.getChangedTurnHash());
 
     //Check if the position has already occured at a similar ply
     if (searchHistTable.hasOccurredAtPly(board.hashPiecesOnly, ply,
                                          board.sideToMove))
     {
-        board.undoCombo(combo);
+        PROFILE_CALL(PROFILE_UNDO, board.undoCombo(combo));
+        if (treeLog)
+            treeLog->addMove(ply, combo.getRawMove(), 0, alpha, beta, alpha,
+                             TREE_MOVE_SEARCH_REPEAT);
         return alpha;
     }
 
@@ -426,13 +637,17 @@ short Search :: doMoveAndSearch(Board& board, int depth, int ply, short alpha,
     
     vector<string> thisPV;
     short nodeScore;
+
+    //id the node searched after the move will get
+    unsigned int childId = numTotalNodes + 1;
     
     //branch off wheter or not the turn has to be passed or not
     if (board.stepsLeft != 0)
     {
         //Check if the move helped the position. If not, then dependent moves
         //must be generated next turn
-        combo.evalScore = eval.evalBoard(board, board.sideToMove);
+        combo.evalScore = PROFILE_CALL(PROFILE_EVAL,
+                              eval.evalBoard(board, board.sideToMove));
 
         bool genDependent;
         if (combo.evalScore <= lastScore)
@@ -455,28 +670,38 @@ short Search :: doMoveAndSearch(Board& board, int depth, int ply, short alpha,
         //as in the beginning of the turn
         if (turnRefer == board.hashPiecesOnly)
         {
-            board.undoCombo(combo);
+            PROFILE_CALL(PROFILE_UNDO, board.undoCombo(combo));
+            if (treeLog)
+                treeLog->addMove(ply, combo.getRawMove(), 0, alpha, beta,
+                                 alpha, TREE_MOVE_NO_CHANGE);
             return alpha;
         }
 
         //Check if the position is now a win for the player that just moved
         if (eval.isWin(board, board.sideToMove))
         {
-            board.undoCombo(combo);  
+            PROFILE_CALL(PROFILE_UNDO, board.undoCombo(combo));
 
             nodePV.resize(0);
             nodePV.insert(nodePV.begin(),
                           combo.toString());           
+            if (treeLog)
+                treeLog->addMove(ply, combo.getRawMove(), 0, alpha, beta,
+                                 beta, TREE_MOVE_GOAL);
             return beta;
         }
             
 
         //Check if the move helped the position. If not, then this move by
         //assumption cannot have been the best move to play
-        combo.evalScore = eval.evalBoard(board, board.sideToMove);
+        combo.evalScore = PROFILE_CALL(PROFILE_EVAL,
+                              eval.evalBoard(board, board.sideToMove));
         if (combo.evalScore <= lastScore)
         {
-            board.undoCombo(combo);            
+            PROFILE_CALL(PROFILE_UNDO, board.undoCombo(combo));
+            if (treeLog)
+                treeLog->addMove(ply, combo.getRawMove(), 0, alpha, beta,
+                                 alpha, TREE_MOVE_NO_GAIN);
             return alpha;
         }
 
@@ -490,7 +715,10 @@ short Search :: doMoveAndSearch(Board& board, int depth, int ply, short alpha,
         if (gameHistTable.getNumOccur(board.hashPiecesOnly) >= 2)
         {   
             board.unchangeTurn(oldnumsteps);
-            board.undoCombo(combo);
+            PROFILE_CALL(PROFILE_UNDO, board.undoCombo(combo));
+            if (treeLog)
+                treeLog->addMove(ply, combo.getRawMove(), 0, alpha, beta,
+                                 alpha, TREE_MOVE_GAME_REPEAT);
             return alpha;
         }
 
@@ -518,7 +746,11 @@ short Search :: doMoveAndSearch(Board& board, int depth, int ply, short alpha,
         board.unchangeTurn(oldnumsteps);
     }
 
-    board.undoCombo(combo);       
+    PROFILE_CALL(PROFILE_UNDO, board.undoCombo(combo));
+
+    if (treeLog)
+        treeLog->addMove(ply, combo.getRawMove(), childId, alpha, beta,
+                         nodeScore, TREE_MOVE_SEARCHED);
 
     if (nodeScore > alpha)
     {
@@ -539,26 +771,135 @@ short Search :: doMoveAndSearch(Board& board, int depth, int ply, short alpha,
     return alpha;
 }
 
+//////////////////////////////////////////////////////////////////////////////
+//Extends the search past the horizon by only playing tactical moves
+//(captures and goals), until the position is quiet, the steps allowed run
+//out, or the node budget for the iteration is used up. The score of the 
+//position without playing any more tactical moves is the lastMove's score
+//at the beginning of a turn. In the middle of a turn, the player can instead
+//pass the rest of the turn, so that score is what the opponent can do
+//tactically afterward. Returns the score within the alpha-beta window.
+//////////////////////////////////////////////////////////////////////////////
+short Search :: quiesceNode(Board& board, int stepsAllowed, int ply, 
+                            short alpha, short beta, StepCombo& lastMove,
+                            Int64 turnRefer)
+{
+    ++numQuiesceNodes;
+
+    //check if this is a winning position
+    if (eval.isWin(board, board.sideToMove)) 
+        return beta;
+
+    bool canExtend = stepsAllowed > 0 && 
+                     numQuiesceNodes < quiesceNodeBudget;
+
+    //Get the score of the position if the player stops here
+    short standScore = lastMove.evalScore;
+    if (canExtend && board.stepsLeft < 4 && board.hashPiecesOnly != turnRefer)
+    {
+        //Pass the rest of the turn and see what the opponent can do
+        unsigned int oldStepsLeft = board.stepsLeft;
+        board.changeTurn();
+
+        StepCombo pass;
+        pass.genPass(board.stepsLeft);
+        pass.evalScore = -lastMove.evalScore;
+        standScore = -quiesceNode(board, stepsAllowed, ply, -beta, -alpha,
+                                  pass, board.hashPiecesOnly);
+
+        board.unchangeTurn(oldStepsLeft);
+    }
+
+    if (standScore >= beta)
+        return beta;
+
+    if (standScore > alpha)
+        alpha = standScore;
+
+    if (!canExtend)
+        return alpha;
+
+    //Check to make sure the combo arrays has entries up to this ply
+    if ((int)combos.size() - 1 < (int)ply)
+        combos.resize(ply + 1);
+
+    combos[ply].clear();
+    if (PROFILE_CALL(PROFILE_GEN_TACTICAL,
+                     board.genTacticalMoves(combos[ply])) == 0)
+        return alpha;
+
+    for (int i = 0; i < combos[ply].size(); ++i)
+    {
+        //Copy the combo out, as the deeper nodes may reallocate the combo
+        //arrays
+        StepCombo next = combos[ply][i];
+        ++numTotalNodes;
+        
+        PROFILE_CALL(PROFILE_PLAY, board.playCombo(next));
+        next.evalScore = PROFILE_CALL(PROFILE_EVAL,
+                             eval.evalBoard(board, board.sideToMove));
+
+        short nodeScore;
+        if (board.stepsLeft != 0)
+        {
+            //keep extending within this player's turn
+            nodeScore = quiesceNode(board, stepsAllowed - next.stepCost,
+                                    ply + next.stepCost, alpha, beta, next,
+                                    turnRefer);
+        }
+        else if (eval.isWin(board, board.sideToMove))
+        {
+            nodeScore = beta;
+        }
+        else
+        {
+            //turn is over, see what the opponent can do in return
+            unsigned int oldStepsLeft = board.stepsLeft;
+            board.changeTurn();
+
+            StepCombo pass;
+            pass.genPass(board.stepsLeft);
+            pass.evalScore = -next.evalScore;
+            nodeScore = -quiesceNode(board, stepsAllowed - next.stepCost,
+                                     ply + next.stepCost, -beta, -alpha, 
+                                     pass, board.hashPiecesOnly);
+
+            board.unchangeTurn(oldStepsLeft);
+        }
+        
+        PROFILE_CALL(PROFILE_UNDO, board.undoCombo(next));
+
+        if (nodeScore > alpha)
+        {
+            alpha = nodeScore;
+            if (alpha >= beta) //beta cutoff
+                return beta;
+        }
+    }
+
+    return alpha;
+}
+
 //////////////////////////////////////////////////////////////////////////////
 //Loads a move file and places all the moves at the beginning of the turn 
 //in the history, using the board given as a reference for hashes. It is 
 //important that the board given is the board used to do searches (or at least
 //a copy of that board with the same hash parts) as the
-//data is only good if the hashes match up.
+//data is only good if the hashes match up. The file is read in place, and
+//takebacks are done by undoing the turns read, so long games are loaded
+//without copying lines or boards.
 //////////////////////////////////////////////////////////////////////////////
 void Search :: loadMoveFile(string filename, Board board)
 {
 
     board.reset();
     
-    //keep a stack of boards so that takebacks can easily be done
-    vector<Board> boardHist;
-    boardHist.push_back(board);
-
+    //keep a stack of the turns played so that takebacks can undo them
+    vector<MoveFileTurn> turns;
 
-    ifstream in(filename.c_str());
+    TextFile in;
     
-    if (!in.is_open())
+    if (!in.open(filename))
     {
         Error error;
         error << "From Search :: loadMoveFile(string, board)\n"
@@ -567,138 +908,213 @@ void Search :: loadMoveFile(string filename, Board board)
         throw error;
     }
 
-    //go through all lines, until the file ends, or quit is signaled
-    bool quit = false;
-    while (!in.eof() || quit)
+    //go through all lines, until the file ends
+    TextRange line;
+    while (in.nextLine(line))
     {
-        string line;
-
-        //read the line
-        getline(in, line);
-        stringstream lineStream(line);
-
-        string word;
-
         //grab the first word, which tells what the the turn number is.
-        lineStream >> word; 
-
-        if (word == string(""))
+        TextRange word;
+        if (!line.nextWord(word))
             break;
 
-        stringstream wordStream(word);
-        if (!isdigit(word[0]))
+        if (!isdigit(*word.begin))
         {
             Error error;
             error << "From Search:: loadMoveFile(string, board)\n"
                   << "Expected turn number as first part in first line\n"
-                  << "Got: " << word << '\n';
+                  << "Got: " << word.toString() << '\n';
             throw error;
         }
 
-        int turnNumber;
-        wordStream >> turnNumber;
+        int turnNumber = 0;
+        while (word.begin < word.end && isdigit(*word.begin))
+            turnNumber = turnNumber * 10 + (*word.begin++ - '0');
 
-        if (turnNumber == 1)
+        //Check if a turn is being taken back instead
+        TextRange rest = line;
+        if (rest.nextWord(word) && word.equals("takeback"))
         {
-            //first turn has pieces being played onto the board, read the
-            //next 16 words which should say where the pieces go
-            
-            bool okay = true;
-            for (int i = 0; i < 16; i++)
+            if (turns.empty())
+                continue;
+
+            //remove an occurence of the current board from the history
+            gameHistTable.decrementOccur(board.hashPiecesOnly);
+
+            //undo the last turn to get back to the board before it
+            MoveFileTurn& turn = turns.back();
+            if (turn.numPlaced > 0)
             {
-                lineStream >> word;
-                
-                if (lineStream.bad())
+                for (int i = 0; i < turn.numPlaced; i++)
                 {
-                    quit = 1;
-                    okay = false;
-                    break;
+                    unsigned char piece = turn.placedPieces[i];
+                    board.removePieceFromBoard(turn.placedSquares[i],
+                                               colorOfPiece(piece),
+                                               typeOfPiece(piece));
                 }
+            }
+            else
+            {
+                board.unchangeTurn(4 - turn.move.stepCost);
+                board.undoCombo(turn.move);
+            }
 
-                //Check if a move is being taken back instead
-                if (word == string("takeback"))
-                {
-                    //remove an occurence of the current board to the history
-                    gameHistTable.decrementOccur(board.hashPiecesOnly);
-
-                    //pop the last board on the stack back onto the current
-                    //state
-                    board = boardHist.back();
-                    boardHist.pop_back();
-
-                    //flag that it is not okay to write this board state
-                    //to history
-                    okay = false;
-                    break;
-                }
+            turns.pop_back();
+            continue;
+        }
 
+        MoveFileTurn turn;
+        turn.numPlaced = 0;
+
+        if (turnNumber == 1)
+        {
+            //first turn has pieces being played onto the board, read the
+            //next 16 words which should say where the pieces go
+            while (turn.numPlaced < 16 && line.nextWord(word))
+            {
                 if (word.length() != 3)
                 {
                     Error error;
                     error << "From Search:: loadMoveFile(string, board)\n";
                     error << "Invalid Format for first piece placement\n";
-                    error << "Got: " << word << '\n';
+                    error << "Got: " << word.toString() << '\n';
                     
                     throw error;
                 }
 
-                //read the piece
-                unsigned char piece = pieceFromChar(word[0]);
-                     
-                //read the location
-                stringstream squareStringStream;    
-                squareStringStream << word[1] << word[2];
-                unsigned char square = 
-                                 squareFromString(squareStringStream.str());
+                //read the piece and the location
+                unsigned char piece = pieceFromChar(word.begin[0]);
+                unsigned char square = squareFromChars(word.begin + 1, 2);
 
                 //write the piece onto the location
                 board.writePieceOnBoard(square, colorOfPiece(piece),
                                                 typeOfPiece(piece));
-                    
-            }
 
-            if (okay)
-            {
-                //Add the current states to the history and the board stack
-                gameHistTable.incrementOccur(board.hashPiecesOnly);
-                boardHist.push_back(board);
+                turn.placedPieces[turn.numPlaced] = piece;
+                turn.placedSquares[turn.numPlaced] = square;
+                turn.numPlaced++;
             }
+
+            if (turn.numPlaced == 0)
+                break;
         }
         else
         {
             //turn should have a list of steps to play
-            StepCombo steps;
-    
-            //get the rest of the line
-            string rest;
-            getline(lineStream, rest);
-
-            if (rest == string("takeback"))
-            {
-                //remove an occurence of the current board to the history
-                gameHistTable.decrementOccur(board.hashPiecesOnly);
-
-                //pop the last board on the stack back onto the current
-                //state
-                board = boardHist.back();
-                boardHist.pop_back();
-
-                continue;
-            }
-
-            if (rest == string(""))
+            if (line.isBlank())
                 break;
 
             //create the steps from the line
-            steps.fromString(rest);
+            turn.move.fromChars(line.begin, line.end);
 
             //play the steps on the board, then give the turn away
-            board.playCombo(steps);
+            board.playCombo(turn.move);
             board.changeTurn();
-        
-            //Add the current states to the history and the board stack
-            gameHistTable.incrementOccur(board.hashPiecesOnly);
-            boardHist.push_back(board);
         }
+
+        //Add the current states to the history and the turn stack
+        gameHistTable.incrementOccur(board.hashPiecesOnly);
+        turns.push_back(turn);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Loads the transposition table and history scores from a snapshot saved at
+//the end of an earlier search, if that search was from earlier in the same
+//game as the board given. The move file has to be loaded first, as the game
+//history is used to check this. The transposition table is mapped straight
+//from the file, and has to be the same size as the current table. Returns
+//true if the snapshot was loaded, and false if there was no snapshot that
+//could be used.
+//////////////////////////////////////////////////////////////////////////////
+bool Search :: loadSnapshot(string filename, Board& board)
+{
+    ifstream in(filename.c_str(), ios::in | ios::binary);
+    if (!in.is_open())
+        return false;
+
+    SearchSnapshotHeader header;
+    in.read((char*)&header, sizeof(header));
+
+    //The snapshot has to have been made with the same hashes and table size,
+    //and the position it searched must have been played in this game, before
+    //the current position
+    if (!in || header.magic != SEARCH_SNAPSHOT_MAGIC ||
+        header.version != SEARCH_SNAPSHOT_VERSION ||
+        header.hashPartsCheck != board.getHashPartsCheck() ||
+        header.numTransEntries != transTable.getNumEntries() ||
+        gameHistTable.getNumOccur(header.rootHash) == 0 ||
+        header.turnNumber * 2 + header.sideToMove >=
+        board.turnNumber * 2 + board.sideToMove)
+    {
+        return false;
+    }
+
+    //The history scores come after the entries. Note that the tables are
+    //reset before the search anyway if the snapshot isn't used after all
+    Int64 transBytes = header.numTransEntries * sizeof(TranspositionEntry);
+    in.seekg(HASH_MEM_FILE_ALIGN + transBytes);
+    if (!eval.histTable.read(in))
+        return false;
+
+    //Go back to an empty table if the file can't be mapped for some reason
+    if (!transTable.mapFile(filename, HASH_MEM_FILE_ALIGN, 
+                            header.numTransEntries))
+    {
+        transTable.setNumEntries(header.numTransEntries);
+        return false;
+    }
+
+    keepTables = true;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Saves the transposition table and history scores after a search from the
+//board given, so that the next search in the same game can start with them.
+//The snapshot is written to a temporary file first and then renamed, so a
+//snapshot that is mapped at the time isn't changed, and a partly written
+//snapshot is never loaded.
+//////////////////////////////////////////////////////////////////////////////
+void Search :: saveSnapshot(string filename, Board& board)
+{
+    string tempFilename = filename + ".tmp";
+    ofstream out(tempFilename.c_str(), 
+                 ios::out | ios::binary | ios::trunc);
+
+    if (!out.is_open())
+    {
+        Error error;
+        error << "From Search :: saveSnapshot(string, Board)\n"
+              << "Could not open file: "
+              << tempFilename << "\n";
+        throw error;
+    }
+
+    SearchSnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = SEARCH_SNAPSHOT_MAGIC;
+    header.version = SEARCH_SNAPSHOT_VERSION;
+    header.hashPartsCheck = board.getHashPartsCheck();
+    header.numTransEntries = transTable.getNumEntries();
+    header.rootHash = board.hashPiecesOnly;
+    header.turnNumber = board.turnNumber;
+    header.sideToMove = board.sideToMove;
+
+    //pad the header so the entries can be mapped
+    vector<char> padding(HASH_MEM_FILE_ALIGN - sizeof(header), 0);
+    out.write((const char*)&header, sizeof(header));
+    out.write(&padding[0], padding.size());
+
+    transTable.write(out);
+    eval.histTable.write(out);
+    out.close();
+
+    if (!out || rename(tempFilename.c_str(), filename.c_str()) != 0)
+    {
+        Error error;
+        error << "From Search :: saveSnapshot(string, Board)\n"
+              << "Could not write file: "
+              << filename << "\n";
+        throw error;
     }
 }
@@ -8,23 +8,62 @@
 #include "gamehist.h"
 #include "searchhist.h"
 #include "hash.h"
+#include "movepicker.h"
 #include "eval.h"
 #include "transposition.h"
+#include "treelog.h"
 #include <string>
 #include <vector>
 
 //some limiting constants
 #define SEARCH_MAX_COMBOS_PER_PLY 120
 
-//hash bit constants
-#define GAME_HIST_HASH_BITS   15
+//limits on the tactical extension past the horizon. The steps limit is the
+//number of steps the extension can play beyond the horizon in one line, and
+//the node budget is the number of extension nodes allowed per iteration
+#define SEARCH_QUIESCE_MAX_STEPS    8
+#define SEARCH_QUIESCE_NODE_BUDGET  1000000
+
+//identifies a file as a table snapshot ("JRSN" read as little endian bytes),
+//and the version of its layout
+#define SEARCH_SNAPSHOT_MAGIC   0x4E53524A
+#define SEARCH_SNAPSHOT_VERSION 1
+
+//Header at the start of a table snapshot file. The header is followed by
+//padding up to HASH_MEM_FILE_ALIGN bytes, the transposition table entries,
+//and then the history scores.
+class SearchSnapshotHeader
+{
+    public:
+    unsigned int magic;         //always SEARCH_SNAPSHOT_MAGIC
+    unsigned int version;       //always SEARCH_SNAPSHOT_VERSION
+    Int64 hashPartsCheck;       //mix of the board's random hash parts, as
+                                //the entries are only good with the same
+                                //hash parts
+    Int64 numTransEntries;      //number of transposition table entries
+    Int64 rootHash;             //hashPiecesOnly of the position searched
+    unsigned int turnNumber;    //turn number of the position searched
+    unsigned int sideToMove;    //player to move in the position searched
+};
 
 using namespace std;
 
+//A turn read from a move file, kept so that it can be taken back. A setup
+//turn keeps the pieces placed, and any other turn keeps the move played.
+class MoveFileTurn
+{
+    public:
+    StepCombo move;                    //move played
+    unsigned char numPlaced;           //number of pieces placed
+    unsigned char placedPieces[16];    //pieces placed
+    unsigned char placedSquares[16];   //squares they were placed on
+};
+
 class Search
 {
     public:
-    Search(Int64 hashTableBytes);
+    Search(Int64 hashTableBytes, Int64 transTableBytes = 0,
+           Int64 searchHistBytes = 0, Int64 evalHashBytes = 0);
     ~Search();
 
     StepCombo iterativeDeepen(Board& board, int maxDepth, ostream& log);
@@ -35,15 +74,50 @@ class Search
     short doMoveAndSearch(Board& board, int depth, int ply, short alpha,  
                           short beta, vector<string>& nodePV,
                           StepCombo& combo, short nodeScore, Int64 turnRefer);
+    short quiesceNode(Board& board, int stepsAllowed, int ply, short alpha,
+                      short beta, StepCombo& lastMove, Int64 turnRefer);
 
     void loadMoveFile(string filename, Board board);  
 
+    bool loadSnapshot(string filename, Board& board);
+    void saveSnapshot(string filename, Board& board);
+
     unsigned int numTerminalNodes; //number of terminal nodes explored
     unsigned int numTotalNodes;    //number of all nodes explored
     unsigned int totalNodesPerSec; //rate at which nodes are explored per 
                                    //second
     unsigned int hashHits; //number of hits on the hash table for scoring
                            //purposes
+    unsigned int numQuiesceNodes; //number of nodes explored past the
+                                  //horizon in the current iteration
+    unsigned int transProbes; //number of lookups in the transposition table
+    unsigned int transHits;   //number of lookups that found an entry
+    unsigned int numCutoffs;  //number of beta cutoffs
+    unsigned int numFirstMoveCutoffs; //number of beta cutoffs caused by the
+                                      //first move tried
+
+    short rootScore; //score of the last finished iteration, in the
+                     //perspective of the player to move at the root
+
+    unsigned int quiesceNodeBudget; //max number of nodes explored past the
+                                    //horizon per iteration, 0 turns off
+                                    //the tactical extension
+
+    //Limits on the search, checked after each iteration, so the iteration
+    //that goes over a limit is still finished. 0 means no limit.
+    Int64 maxNodes;    //number of nodes explored
+    double maxSeconds; //time taken
+
+    //stream to write a telemetry record to after each iteration and at the
+    //end of the search, or 0 for none
+    ostream* telemetry;
+
+    //buffer to record the nodes and moves of each search in, or 0 for none
+    SearchTreeLog* treeLog;
+
+    //set when the tables were loaded from a snapshot, so that the next
+    //search starts with them instead of resetting them
+    bool keepTables;
 
     //a hash table to keep transposition data.
     TranspositionTable transTable;
@@ -62,6 +136,9 @@ class Search
     //ply. The inner vector keeps the combos for that ply
     vector<vector<StepCombo> > combos;
 
+    //pickers of the order to search the combos of each ply in
+    vector<MovePicker> pickers;
+
     //Eval instance to score stuff
     Eval eval;
 };
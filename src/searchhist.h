@@ -3,49 +3,102 @@
 
 #include "hash.h"
 #include "int64.h"
+#include "piece.h"
+
+//mask of the bits of the hash kept in each entry to check the key
+#define SEARCH_HIST_KEY_MASK 0xFFFFFFFFFFULL
 
 //Hash entry to keep the earlist occurence of a board state relative to
 //the board state in the beginning of a turn.
 class SearchHistEntry
 {
+    //data is packed into a 64 bit integer as follows:
+    //bit 0-7   : earliest ply the board state occurred for gold to move
+    //bit 8-15  : earliest ply the board state occurred for silver to move
+    //bit 16-23 : generation of the search that wrote this entry. The entry
+    //            is only valid during that search
+    //bit 24-63 : lower 40 bits of the hash, to check the entry is for the
+    //            same board state. The lower bits are used as the table
+    //            index comes from the upper bits
+
     public:
+    //////////////////////////////////////////////////////////////////////////
     //Earliest ply this board state has occurred relative to the root node
-    //of the tree, indexed by player color.
-    unsigned char earliestOccur[MAX_COLORS];
+    //of the tree, for that player color.
+    //////////////////////////////////////////////////////////////////////////
+    unsigned char getEarliestOccur(unsigned char color)
+    {
+        return (data >> (8 * color)) & 0xFF;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //Sets the earliest ply this board state has occurred for that color
+    //////////////////////////////////////////////////////////////////////////
+    void setEarliestOccur(unsigned char color, unsigned char ply)
+    {
+        data &= ~((Int64)0xFF << (8 * color));
+        data |= (Int64)ply << (8 * color);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //Returns the generation of the search this entry was written in
+    //////////////////////////////////////////////////////////////////////////
+    unsigned char getGeneration()
+    {
+        return (data >> 16) & 0xFF;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //Returns true if the entry was written for that hash
+    //////////////////////////////////////////////////////////////////////////
+    bool matches(Int64 hash)
+    {
+        return (data >> 24) == (hash & SEARCH_HIST_KEY_MASK);
+    }
 
-    Int64 hash; //The full hash value
+    //////////////////////////////////////////////////////////////////////////
+    //Sets the entry to be for that hash in that generation, with both
+    //earliest occurences at the ply given
+    //////////////////////////////////////////////////////////////////////////
+    void set(Int64 hash, unsigned char generation, unsigned char ply)
+    {
+        data = ((hash & SEARCH_HIST_KEY_MASK) << 24)
+             | ((Int64)generation << 16)
+             | ((Int64)ply << 8)
+             | ply;
+    }
+
+    Int64 data;
 };
 
 //Hash table to keep occurences of the same board state within the same turn.
 //Logically within a player's turn, there is no need to search a node that
 //is a board state that has already been searched elsewhere at a greater
 //depth, as then it cannot possibly be better than the already searched line.
+//Entries are stamped with the generation of the search that wrote them, so
+//that starting a new search throws out every entry without touching them.
 class SearchHistTable
 {
     public:
     //////////////////////////////////////////////////////////////////////////
-    //sets the table size to handle all keys that have the specified number of 
-    //bits. That is the table is set to 2 ^ (numbits) entries. Also sets the
-    //hash mask to enforce that keys are limited to that number of bits
+    //sets the table to have the specified number of entries, which need not
+    //be a power of 2
     //////////////////////////////////////////////////////////////////////////
-    void setHashKeySize(unsigned int numBits)
+    void setNumEntries(Int64 numEntries)
     {
-        hashes.init(Int64FromIndex(numBits)); 
-        hashMask = Int64LowerBitsFilled(numBits);        
+        hashes.init(numEntries);
+        clear();
     }
 
     //////////////////////////////////////////////////////////////////////////
-    //Reset every entry to have no known occurences.
+    //Reset every entry to have no known occurences. This just starts a new
+    //generation, unless the generations have run out.
     //////////////////////////////////////////////////////////////////////////
     void reset()
     {
-        
-        for (int i = 0; i < hashes.getNumEntries(); i++)
-        {
-            hashes.getEntry(i).earliestOccur[GOLD]   = 255;
-            hashes.getEntry(i).earliestOccur[SILVER] = 255;
-            hashes.getEntry(i).hash = 0;
-        }
+        ++generation;
+        if (generation == 0)
+            clear();
     }
 
     //////////////////////////////////////////////////////////////////////////
@@ -53,10 +106,11 @@ class SearchHistTable
     //or equal ply than the input ply from the root for that player
     //////////////////////////////////////////////////////////////////////////
     bool hasOccurredAtPly(Int64 hash, unsigned char ply, unsigned char color)
-    {   
-        SearchHistEntry& hist = hashes.getEntry(hash & hashMask);
-        return (hist.hash == hash &&  hist.earliestOccur[color] < ply);
-    }      
+    {
+        SearchHistEntry& hist = hashes.getEntry(hashes.getIndex(hash));
+        return hist.getGeneration() == generation && hist.matches(hash) &&
+               hist.getEarliestOccur(color) < ply;
+    }
 
     //////////////////////////////////////////////////////////////////////////
     //Attempts to write a hash entry for the input hash occuring at the
@@ -66,36 +120,65 @@ class SearchHistTable
     //////////////////////////////////////////////////////////////////////////
     void setOccur(Int64 hash, unsigned char ply, unsigned char color)
     {
-        SearchHistEntry& hist = hashes.getEntry(hash & hashMask);
+        SearchHistEntry& hist = hashes.getEntry(hashes.getIndex(hash));
 
-        if (hash == hist.hash)
+        if (hist.getGeneration() != generation)
         {
-            //If the full hashes match, update the occurence for the
+            //Entry is from an older search, so it is free to take
+            hist.set(hash, generation, ply);
+        }
+        else if (hist.matches(hash))
+        {
+            //If the hashes match, update the occurence for the
             //specified color
-            if (ply < hist.earliestOccur[color])
-                hist.earliestOccur[color] = ply;
+            if (ply < hist.getEarliestOccur(color))
+                hist.setEarliestOccur(color, ply);
         }
         else
         {
             //Otherwise, check to see if the ply is lower than both
             //of the entry's occurrences and if so, update the occurence
             //for the specified color and reset the other color
-            if (ply < hist.earliestOccur[GOLD] &&
-                ply < hist.earliestOccur[SILVER])
+            if (ply < hist.getEarliestOccur(GOLD) &&
+                ply < hist.getEarliestOccur(SILVER))
             {
-                hist.hash  = hash;
-                hist.earliestOccur[color] = ply;
-                hist.earliestOccur[oppColorOf(color)] = ply;
+                hist.set(hash, generation, ply);
             }
         }
     }
 
+    //////////////////////////////////////////////////////////////////////////
+    //Starts loading the entry for that hash key into the cache
+    //////////////////////////////////////////////////////////////////////////
+    void prefetch(Int64 hash)
+    {
+        hashes.prefetch(hashes.getIndex(hash));
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //Returns a description of the memory the table was given
+    //////////////////////////////////////////////////////////////////////////
+    string getMemDescription()
+    {
+        return hashes.getMemDescription();
+    }
+
     private:
+    //////////////////////////////////////////////////////////////////////////
+    //Writes every entry as belonging to no generation, and starts at the
+    //first generation
+    //////////////////////////////////////////////////////////////////////////
+    void clear()
+    {
+        hashes.clear();
+        generation = 1;
+    }
+
     //Internal hash table to keep the entries
     HashTable<SearchHistEntry> hashes;
 
-    //Mask to limit bits on accessing hashes
-    Int64 hashMask;
+    //Generation of the current search
+    unsigned char generation;
 };
 
 #endif
@@ -0,0 +1,332 @@
+#include "selfplay.h"
+#include "board.h"
+#include "int64.h"
+#include "piece.h"
+#include "search.h"
+#include "square.h"
+#include "step.h"
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <math.h>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+//////////////////////////////////////////////////////////////////////////////
+//Returns the elo difference that gives the expected score given, which is
+//kept away from 0 and 1 so the difference stays finite
+//////////////////////////////////////////////////////////////////////////////
+static double eloFromScore(double score)
+{
+    if (score < 0.001)
+        score = 0.001;
+    if (score > 0.999)
+        score = 0.999;
+
+    return 400.0 * log10(score / (1.0 - score));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Returns true if the player has no rabbits left
+//////////////////////////////////////////////////////////////////////////////
+static bool hasNoRabbits(Board& board, unsigned char color)
+{
+    return board.pieces[color][RABBIT] == 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Constructor, with the two players of the match
+//////////////////////////////////////////////////////////////////////////////
+SelfPlay :: SelfPlay(SelfPlayPlayer first, SelfPlayPlayer second)
+{
+    players[0] = first;
+    players[1] = second;
+    openingMoves = SELFPLAY_OPENING_MOVES;
+    maxMoves = SELFPLAY_MAX_MOVES;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Plays the number of games given, split over the threads, and writes the
+//result of each game and of the whole match to the log. Returns the
+//results.
+//////////////////////////////////////////////////////////////////////////////
+SelfPlayResults SelfPlay :: play(int numGames, int numThreads, ostream& log)
+{
+    if (numThreads < 1)
+        numThreads = 1;
+    if (numThreads > numGames)
+        numThreads = numGames;
+
+    //every game starts from the default setups, gold to move on turn 2
+    Board base;
+    base.genRandomHashes();
+    base.reset();
+
+    stringstream setups(SELFPLAY_GOLD_SETUP " " SELFPLAY_SILVER_SETUP);
+    string word;
+    while (setups >> word)
+    {
+        unsigned char piece = pieceFromChar(word[0]);
+        base.writePieceOnBoard(squareFromString(word.substr(1)),
+                               colorOfPiece(piece), typeOfPiece(piece));
+    }
+
+    base.turnNumber = 2;
+    base.hash ^= base.hashTurnParts[GOLD];
+    base.hash ^= base.hashStepsLeftParts[4];
+
+    SelfPlayResults results;
+    nextGame = 0;
+
+    vector<thread> threads;
+    for (int t = 0; t < numThreads; t++)
+    {
+        threads.push_back(thread(&SelfPlay::playGames, this, base, numGames,
+                                 ref(results), ref(log)));
+    }
+    for (int t = 0; t < numThreads; t++)
+        threads[t].join();
+
+    //The score of each game is 1, 0.5, or 0, so the standard error of the
+    //average score comes from the spread of those
+    int numPlayed = results.wins + results.losses + results.draws;
+    double score = 0.5;
+    double error = 0;
+    if (numPlayed > 0)
+    {
+        score = (results.wins + 0.5 * results.draws) / numPlayed;
+        double meanSquare = (results.wins + 0.25 * results.draws)
+                            / numPlayed;
+        double variance = meanSquare - score * score;
+        if (variance > 0)
+            error = 1.96 * sqrt(variance / numPlayed);
+    }
+
+    double elo = eloFromScore(score);
+    double eloError = fabs(eloFromScore(score + error)
+                           - eloFromScore(score - error)) / 2;
+
+    log << "Played " << numPlayed << " games: " << results.wins
+        << " wins, " << results.losses << " losses, " << results.draws
+        << " draws for the first player, "
+        << (numPlayed > 0 ? results.moves / numPlayed : 0)
+        << " moves per game\n";
+    log << "Score " << fixed << setprecision(1) << score * 100 << "%, elo "
+        << showpos << elo << noshowpos << " +/- " << eloError
+        << " (95%)\n";
+    for (int p = 0; p < 2; p++)
+    {
+        log << (p == 0 ? "First" : "Second") << " player searched "
+            << results.nodes[p] << " nodes at "
+            << (Int64)(results.seconds[p] > 0 ? results.nodes[p]
+                                                / results.seconds[p] : 0)
+            << " nodes/sec\n";
+    }
+    log.unsetf(ios::fixed);
+    log << setprecision(6);
+    log.flush();
+
+    return results;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Plays games, taking the next one not taken by any thread, until all the
+//games are played. Each thread has its own search for each player.
+//////////////////////////////////////////////////////////////////////////////
+void SelfPlay :: playGames(Board base, int numGames,
+                           SelfPlayResults& results, ostream& log)
+{
+    Search* searches[2];
+    for (int p = 0; p < 2; p++)
+    {
+        searches[p] = new Search(players[p].hashTableBytes);
+        searches[p]->eval.loadWeights(players[p].weightFile);
+        searches[p]->quiesceNodeBudget = players[p].quiesceNodes;
+        searches[p]->maxNodes = players[p].maxNodes;
+        searches[p]->maxSeconds = players[p].maxSeconds;
+    }
+
+    int game;
+    while ((game = nextGame++) < numGames)
+    {
+        SelfPlayResults gameResults;
+        int winner = playGame(base, searches, game, gameResults);
+
+        lock_guard<mutex> lock(resultsMutex);
+        for (int p = 0; p < 2; p++)
+        {
+            results.nodes[p] += gameResults.nodes[p];
+            results.seconds[p] += gameResults.seconds[p];
+        }
+        results.moves += gameResults.moves;
+
+        log << "Game " << game + 1 << ", first player as "
+            << (game % 2 == 0 ? "gold" : "silver") << ": ";
+        if (winner == 0)
+        {
+            results.wins++;
+            log << "won";
+        }
+        else if (winner == 1)
+        {
+            results.losses++;
+            log << "lost";
+        }
+        else
+        {
+            results.draws++;
+            log << "draw";
+        }
+        log << " after " << gameResults.moves << " moves\n";
+        log.flush();
+    }
+
+    for (int p = 0; p < 2; p++)
+        delete searches[p];
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Plays one game from the board given, and adds the nodes and time of each
+//player's searches and the moves played to the results. The first player
+//is gold in even games. Returns the player that won, 0 or 1, or -1 for a
+//draw.
+//////////////////////////////////////////////////////////////////////////////
+int SelfPlay :: playGame(Board board, Search* searches[2], int game,
+                         SelfPlayResults& results)
+{
+    int playerOfColor[MAX_COLORS];
+    playerOfColor[GOLD] = game % 2;
+    playerOfColor[SILVER] = 1 - game % 2;
+
+    for (int p = 0; p < 2; p++)
+    {
+        searches[p]->gameHistTable.reset();
+        searches[p]->gameHistTable.incrementOccur(board.hashPiecesOnly);
+    }
+
+    //both games of a pair get the same opening
+    playOpening(board, searches, game / 2);
+
+    //the searches don't need a log
+    ostream noLog(0);
+
+    for (int move = 0; move < maxMoves; move++)
+    {
+        unsigned char color = board.sideToMove;
+        unsigned char opp = oppColorOf(color);
+        int player = playerOfColor[color];
+        Search& search = *searches[player];
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        StepCombo bestMove = search.iterativeDeepen(board,
+                                                    players[player].maxDepth,
+                                                    noLog);
+        results.seconds[player] += chrono::duration<double>(
+                                   chrono::steady_clock::now() - start)
+                                   .count();
+        results.nodes[player] += search.numTotalNodes;
+
+        //a player with no move that changes the position loses
+        Int64 turnStart = board.hashPiecesOnly;
+        if (bestMove.stepCost == 0)
+            return playerOfColor[opp];
+
+        board.playCombo(bestMove);
+        board.changeTurn();
+        if (board.sideToMove == GOLD)
+            board.turnNumber++;
+        results.moves++;
+
+        if (board.hashPiecesOnly == turnStart)
+            return playerOfColor[opp];
+
+        //so does one that makes a position occur a third time
+        bool repeated = false;
+        for (int p = 0; p < 2; p++)
+        {
+            searches[p]->gameHistTable.incrementOccur(board.hashPiecesOnly);
+            if (searches[p]->gameHistTable.getNumOccur(board.hashPiecesOnly)
+                >= 3)
+                repeated = true;
+        }
+        if (repeated)
+            return playerOfColor[opp];
+
+        //the goal is checked for the player that moved first
+        if (search.eval.isWin(board, color))
+            return playerOfColor[color];
+        if (search.eval.isWin(board, opp))
+            return playerOfColor[opp];
+        if (hasNoRabbits(board, opp))
+            return playerOfColor[color];
+        if (hasNoRabbits(board, color))
+            return playerOfColor[opp];
+    }
+
+    return -1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Plays random moves that don't capture at the start of a game, so the games
+//of a match are different. The same seed gives the same moves.
+//////////////////////////////////////////////////////////////////////////////
+void SelfPlay :: playOpening(Board& board, Search* searches[2],
+                             unsigned int seed)
+{
+    mt19937 random(seed);
+    vector<StepCombo> combos;
+
+    for (int i = 0; i < openingMoves; i++)
+    {
+        Int64 turnStart = board.hashPiecesOnly;
+
+        //play random moves until the steps run out, trying again if the
+        //position ends up where it started
+        StepCombo move;
+        for (int tries = 0; tries < 10; tries++)
+        {
+            while (board.stepsLeft > 0)
+            {
+                combos.clear();
+                board.genMoves(combos);
+
+                vector<StepCombo> fitting;
+                for (unsigned int j = 0; j < combos.size(); j++)
+                {
+                    if (combos[j].stepCost <= board.stepsLeft &&
+                        combos[j].numSteps == combos[j].stepCost)
+                        fitting.push_back(combos[j]);
+                }
+
+                if (fitting.empty())
+                    break;
+
+                StepCombo& combo = fitting[random() % fitting.size()];
+                board.playCombo(combo);
+                move.addCombo(combo);
+            }
+
+            if (board.hashPiecesOnly != turnStart)
+                break;
+
+            board.undoCombo(move);
+            move.reset();
+        }
+
+        if (board.hashPiecesOnly == turnStart)
+            return;
+
+        board.changeTurn();
+        if (board.sideToMove == GOLD)
+            board.turnNumber++;
+
+        for (int p = 0; p < 2; p++)
+            searches[p]->gameHistTable.incrementOccur(board.hashPiecesOnly);
+    }
+}
@@ -0,0 +1,110 @@
+#ifndef __JR_SELFPLAY_H__
+#define __JR_SELFPLAY_H__
+
+//Matches of games the bot plays against itself, to compare two weight files
+//or two search configurations
+
+#include "board.h"
+#include "int64.h"
+#include "search.h"
+#include "step.h"
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//setups both players use, the default setup of each color
+#define SELFPLAY_GOLD_SETUP   "Ra1 Rb1 Rc1 Dd1 De1 Rf1 Rg1 Rh1 " \
+                              "Ra2 Hb2 Cc2 Md2 Ee2 Cf2 Hg2 Rh2"
+#define SELFPLAY_SILVER_SETUP "ra8 rb8 rc8 dd8 de8 rf8 rg8 rh8 " \
+                              "ra7 hb7 cc7 md7 ee7 cf7 hg7 rh7"
+
+//number of random moves played at the start of each game by default, so
+//the games aren't all the same
+#define SELFPLAY_OPENING_MOVES 4
+
+//number of moves after which a game is called a draw
+#define SELFPLAY_MAX_MOVES 300
+
+using namespace std;
+
+//How one player of a match searches
+class SelfPlayPlayer
+{
+    public:
+    SelfPlayPlayer()
+    {
+        weightFile = string("evalWeights/weights.txt");
+        maxDepth = 8;
+        maxNodes = 0;
+        maxSeconds = 0;
+        hashTableBytes = 16 * 1024 * 1024;
+        quiesceNodes = SEARCH_QUIESCE_NODE_BUDGET;
+    }
+
+    string weightFile;    //eval weights to load
+    int maxDepth;         //max depth to search to
+    Int64 maxNodes;       //nodes after which no new iteration is started,
+                          //0 for no limit
+    double maxSeconds;    //seconds after which no new iteration is
+                          //started, 0 for no limit
+    Int64 hashTableBytes; //size of all the hash tables of the search
+    int quiesceNodes;     //tactical extension node budget per iteration
+};
+
+//Results of a match, in the perspective of the first player
+class SelfPlayResults
+{
+    public:
+    SelfPlayResults()
+    {
+        wins = 0;
+        losses = 0;
+        draws = 0;
+        moves = 0;
+        for (int p = 0; p < 2; p++)
+        {
+            nodes[p] = 0;
+            seconds[p] = 0;
+        }
+    }
+
+    int wins;          //games the first player won
+    int losses;        //games the first player lost
+    int draws;         //games that ran out of moves
+    int moves;         //moves played in all games
+
+    Int64 nodes[2];    //nodes each player searched
+    double seconds[2]; //time each player searched for
+};
+
+//Plays games between two players, several at a time. Each game starts from
+//the default setups and a few random moves, and every opening is played
+//twice with the players switching colors. A player loses by letting the
+//opponent reach the goal, by having no rabbits left, by having no move to
+//play, or by making a position occur for the third time.
+class SelfPlay
+{
+    public:
+    SelfPlay(SelfPlayPlayer first, SelfPlayPlayer second);
+
+    SelfPlayResults play(int numGames, int numThreads, ostream& log);
+
+    int openingMoves; //random moves at the start of each game
+    int maxMoves;     //moves after which a game is a draw
+
+    private:
+    void playGames(Board base, int numGames, SelfPlayResults& results,
+                   ostream& log);
+    int playGame(Board board, Search* searches[2], int game,
+                 SelfPlayResults& results);
+    void playOpening(Board& board, Search* searches[2], unsigned int seed);
+
+    SelfPlayPlayer players[2]; //the two players, first and second
+
+    atomic<int> nextGame;      //next game to be played by any thread
+    mutex resultsMutex;        //guards the results and the log
+};
+
+#endif
@@ -0,0 +1,145 @@
+#include "error.h"
+#include "int64.h"
+#include "selfplay.h"
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+//////////////////////////////////////////////////////////////////////////////
+//Sets an option of the players from a flag and its value. A flag ending in
+//1 or 2 sets the option of only the first or second player, and one without
+//sets it for both. Returns false if the flag isn't a player option.
+//////////////////////////////////////////////////////////////////////////////
+bool setPlayerOption(SelfPlayPlayer players[2], string flag, string value)
+{
+    int first = 0;
+    int last = 1;
+    char lastChar = flag[flag.length() - 1];
+    if (lastChar == '1' || lastChar == '2')
+    {
+        first = last = lastChar - '1';
+        flag = flag.substr(0, flag.length() - 1);
+    }
+
+    for (int p = first; p <= last; p++)
+    {
+        if (flag == string("--weights"))
+            players[p].weightFile = value;
+        else if (flag == string("--depth"))
+            players[p].maxDepth = atoi(value.c_str());
+        else if (flag == string("--nodes"))
+            players[p].maxNodes = atoll(value.c_str());
+        else if (flag == string("--time"))
+            players[p].maxSeconds = atof(value.c_str());
+        else if (flag == string("--hashtablesize"))
+            players[p].hashTableBytes = (Int64)atoi(value.c_str())
+                                        * 1024 * 1024;
+        else if (flag == string("--quiescenodes"))
+            players[p].quiesceNodes = atoi(value.c_str());
+        else
+            return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char * args[])
+{
+    try
+    {
+        //initialize the 64 bit arrays
+        initInt64();
+        srand(0);
+
+        SelfPlayPlayer players[2];
+        int numGames = 100;
+        int numThreads = thread::hardware_concurrency();
+        int openingMoves = SELFPLAY_OPENING_MOVES;
+        int maxMoves = SELFPLAY_MAX_MOVES;
+        bool help = false;
+
+        for (int i = 1; i < argc; ++i)
+        {
+            string flag = args[i];
+            if (flag == string("--help"))
+            {
+                help = true;
+                continue;
+            }
+
+            if (i + 1 >= argc)
+            {
+                help = true;
+                break;
+            }
+
+            string value = args[i+1];
+            ++i;
+
+            if (flag == string("--games"))
+                numGames = atoi(value.c_str());
+            else if (flag == string("--threads"))
+                numThreads = atoi(value.c_str());
+            else if (flag == string("--openingmoves"))
+                openingMoves = atoi(value.c_str());
+            else if (flag == string("--maxmoves"))
+                maxMoves = atoi(value.c_str());
+            else if (!setPlayerOption(players, flag, value))
+                help = true;
+        }
+
+        if (help)
+        {
+            cout << "Jr Arimaa Bot self play\n";
+            cout << "Usage: selfplay [flags]\n\n";
+            cout << "Plays games between two players and reports the"
+                 << " score and elo difference\nof the first player."
+                 << " Player flags ending in 1 or 2 set only that"
+                 << " player,\nand otherwise set both.\n\n";
+            cout << "Flags:\n\n";
+            cout << "--games num\nNumber of games to play. Defaults to"
+                 << " 100\n\n";
+            cout << "--threads num\nNumber of games played at once."
+                 << " Defaults to the number of cores\n\n";
+            cout << "--openingmoves num\nNumber of random moves at the"
+                 << " start of each game. Defaults to "
+                 << SELFPLAY_OPENING_MOVES << "\n\n";
+            cout << "--maxmoves num\nNumber of moves after which a game"
+                 << " is a draw. Defaults to " << SELFPLAY_MAX_MOVES
+                 << "\n\n";
+            cout << "--weights[1|2] weightFile\nEval weight file. Defaults"
+                 << " to evalWeights/weights.txt\n\n";
+            cout << "--depth[1|2] max\nMax search depth. Defaults to"
+                 << " 8\n\n";
+            cout << "--nodes[1|2] num\nNodes after which no new"
+                 << " iteration is started. 0, the default,\nis no"
+                 << " limit\n\n";
+            cout << "--time[1|2] seconds\nSeconds after which no new"
+                 << " iteration is started. 0, the\ndefault, is no"
+                 << " limit\n\n";
+            cout << "--hashtablesize[1|2] num\nSize of the hash tables of"
+                 << " each search in MB. Defaults to 16\n\n";
+            cout << "--quiescenodes[1|2] num\nTactical extension node"
+                 << " budget per iteration. Defaults to "
+                 << SEARCH_QUIESCE_NODE_BUDGET << "\n\n";
+            return 0;
+        }
+
+        SelfPlay selfPlay(players[0], players[1]);
+        selfPlay.openingMoves = openingMoves;
+        selfPlay.maxMoves = maxMoves;
+        selfPlay.play(numGames, numThreads, cout);
+    }
+
+    catch (Error error)
+    {
+        cerr << "Caught Error: \n"
+             << error << endl;
+        return 1;
+    }
+
+    return 0;
+}
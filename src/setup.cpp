@@ -0,0 +1,300 @@
+#include "setup.h"
+#include "board.h"
+#include "eval.h"
+#include "int64.h"
+#include "piece.h"
+#include "search.h"
+#include "square.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+//////////////////////////////////////////////////////////////////////////////
+//Orders candidates from best to worst, searched candidates by their searched
+//score first and then the rest by their static score
+//////////////////////////////////////////////////////////////////////////////
+static bool betterCandidate(const SetupCandidate& a, const SetupCandidate& b)
+{
+    if (a.searched != b.searched)
+        return a.searched;
+    if (a.searched && a.searchScore != b.searchScore)
+        return a.searchScore > b.searchScore;
+    return a.staticScore > b.staticScore;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Returns the index of a square given the row from the back row of that
+//color, and the column
+//////////////////////////////////////////////////////////////////////////////
+static unsigned char setupSquare(unsigned char color, int row, int col)
+{
+    if (color == GOLD)
+        return (7 - row) * 8 + col;
+    else
+        return row * 8 + col;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Constructor. The eval weights are loaded by each thread from the file given
+//////////////////////////////////////////////////////////////////////////////
+SetupSearch :: SetupSearch(string evalWeightFile, int numThreads)
+{
+    if (numThreads < 1)
+        numThreads = 1;
+
+    this->evalWeightFile = evalWeightFile;
+    this->numThreads = numThreads;
+    depth = SETUP_SEARCH_DEPTH;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Finds the best setup for the player to move on the board, which has to be
+//on the first turn, and returns it in the move format. The search stops
+//starting new candidates after the given number of seconds.
+//////////////////////////////////////////////////////////////////////////////
+string SetupSearch :: findSetup(Board& board, double seconds, ostream& log)
+{
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    unsigned char color = board.sideToMove;
+
+    //Set up the board the candidates are placed on. Gold can't know the
+    //opponent's setup, so the default one is assumed. Either way it is gold
+    //to move on the second turn once the candidate is placed
+    Board base = board;
+    if (color == GOLD)
+    {
+        stringstream opponentSetup(SETUP_DEFAULT_SILVER);
+        string word;
+        while (opponentSetup >> word)
+        {
+            unsigned char piece = pieceFromChar(word[0]);
+            base.writePieceOnBoard(squareFromString(word.substr(1)),
+                                   colorOfPiece(piece), typeOfPiece(piece));
+        }
+    }
+    else
+    {
+        base.changeTurn();
+    }
+    base.turnNumber = 2;
+
+    vector<SetupCandidate> candidates;
+    genCandidates(candidates);
+
+    //score every candidate statically, each thread taking every nth one
+    vector<thread> threads;
+    for (int t = 0; t < numThreads; t++)
+    {
+        threads.push_back(thread(&SetupSearch::scoreStatic, this, base,
+                                 color, ref(candidates), t));
+    }
+    for (int t = 0; t < numThreads; t++)
+        threads[t].join();
+
+    //then search the best of them, as long as there is time
+    unsigned int numSearched = min((unsigned int)candidates.size(),
+                                   (unsigned int)SETUP_NUM_SEARCHED);
+    partial_sort(candidates.begin(), candidates.begin() + numSearched,
+                 candidates.end(), betterCandidate);
+
+    double secondsLeft = seconds - chrono::duration<double>(
+                                   chrono::steady_clock::now() - start).count();
+    nextCandidate = 0;
+    threads.clear();
+    for (int t = 0; t < numThreads; t++)
+    {
+        threads.push_back(thread(&SetupSearch::scoreSearch, this, base,
+                                 color, ref(candidates), numSearched,
+                                 secondsLeft));
+    }
+    for (int t = 0; t < numThreads; t++)
+        threads[t].join();
+
+    sort(candidates.begin(), candidates.begin() + numSearched,
+         betterCandidate);
+
+    unsigned int numDone = min((unsigned int)nextCandidate, numSearched);
+    log << "Scored " << candidates.size() << " setups, searched "
+        << numDone << " of them to depth " << depth << " in "
+        << chrono::duration<double>(chrono::steady_clock::now() - start)
+           .count()
+        << " seconds\n";
+    log << "Best setup static score " << candidates[0].staticScore;
+    if (candidates[0].searched)
+        log << ", searched score " << candidates[0].searchScore;
+    log << endl;
+
+    return setupString(candidates[0], color);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Generates every candidate setup the template allows
+//////////////////////////////////////////////////////////////////////////////
+void SetupSearch :: genCandidates(vector<SetupCandidate>& candidates)
+{
+    //The squares of the left half other than the strong square, as row and
+    //column
+    int halfSquares[7][2];
+    int numHalfSquares = 0;
+    for (int row = 0; row < 2; row++)
+    {
+        for (int col = 0; col < 4; col++)
+        {
+            if (row == 1 && col == setupTemplate.strongCol)
+                continue;
+            halfSquares[numHalfSquares][0] = row;
+            halfSquares[numHalfSquares][1] = col;
+            numHalfSquares++;
+        }
+    }
+
+    //Every arrangement of a horse, dog, and cat on those squares, with
+    //rabbits on the rest
+    vector<vector<unsigned char> > halves;
+    for (int h = 0; h < 7; h++)
+    {
+        for (int d = 0; d < 7; d++)
+        {
+            for (int c = 0; c < 7; c++)
+            {
+                if (h == d || h == c || d == c)
+                    continue;
+
+                vector<unsigned char> half(7, RABBIT);
+                half[h] = HORSE;
+                half[d] = DOG;
+                half[c] = CAT;
+                halves.push_back(half);
+            }
+        }
+    }
+
+    SetupCandidate candidate;
+    candidate.staticScore = 0;
+    candidate.searchScore = 0;
+    candidate.searched = false;
+
+    for (int elephantLeft = 0; elephantLeft < 2; elephantLeft++)
+    {
+        int strongCol = setupTemplate.strongCol;
+        candidate.types[1][strongCol] = elephantLeft ? ELEPHANT : CAMEL;
+        candidate.types[1][7 - strongCol] = elephantLeft ? CAMEL : ELEPHANT;
+
+        for (unsigned int left = 0; left < halves.size(); left++)
+        {
+            for (unsigned int right = 0; right < halves.size(); right++)
+            {
+                if (setupTemplate.mirror && right != left)
+                    continue;
+
+                for (int i = 0; i < 7; i++)
+                {
+                    int row = halfSquares[i][0];
+                    int col = halfSquares[i][1];
+                    candidate.types[row][col] = halves[left][i];
+                    candidate.types[row][7 - col] = halves[right][i];
+                }
+
+                candidates.push_back(candidate);
+            }
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Writes the pieces of a candidate onto the board for that color
+//////////////////////////////////////////////////////////////////////////////
+void SetupSearch :: placeSetup(Board& board, SetupCandidate& candidate,
+                               unsigned char color)
+{
+    for (int row = 0; row < 2; row++)
+    {
+        for (int col = 0; col < 8; col++)
+        {
+            board.writePieceOnBoard(setupSquare(color, row, col), color,
+                                    candidate.types[row][col]);
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Gives the candidates the thread is responsible for their static score, in
+//the perspective of the player setting up
+//////////////////////////////////////////////////////////////////////////////
+void SetupSearch :: scoreStatic(Board base, unsigned char color,
+                                vector<SetupCandidate>& candidates,
+                                int thread)
+{
+    Eval eval;
+    eval.loadWeights(evalWeightFile);
+    eval.hashTable.setNumEntries(1);
+
+    for (unsigned int i = thread; i < candidates.size(); i += numThreads)
+    {
+        Board board = base;
+        placeSetup(board, candidates[i], color);
+        candidates[i].staticScore = eval.evalBoard(board, color);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Searches candidates, taking the next one not taken by any thread, until
+//the first numSearched candidates are done or the time runs out
+//////////////////////////////////////////////////////////////////////////////
+void SetupSearch :: scoreSearch(Board base, unsigned char color,
+                                vector<SetupCandidate>& candidates,
+                                unsigned int numSearched, double seconds)
+{
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    Search search(SETUP_SEARCH_HASH_BYTES);
+    search.eval.loadWeights(evalWeightFile);
+
+    //the search log isn't needed
+    ostream noLog(0);
+
+    while (chrono::duration<double>(chrono::steady_clock::now() - start)
+           .count() < seconds)
+    {
+        unsigned int i = nextCandidate++;
+        if (i >= numSearched)
+            break;
+
+        Board board = base;
+        placeSetup(board, candidates[i], color);
+        search.iterativeDeepen(board, depth, noLog);
+
+        //the search is always from gold's perspective
+        candidates[i].searchScore = color == GOLD ? search.rootScore
+                                                  : -search.rootScore;
+        candidates[i].searched = true;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Returns the setup of a candidate in the move format
+//////////////////////////////////////////////////////////////////////////////
+string SetupSearch :: setupString(SetupCandidate& candidate,
+                                  unsigned char color)
+{
+    stringstream setup;
+    for (int row = 0; row < 2; row++)
+    {
+        for (int col = 0; col < 8; col++)
+        {
+            if (row != 0 || col != 0)
+                setup << " ";
+            setup << charFromPiece(genPiece(color, candidate.types[row][col]))
+                  << stringFromSquare(setupSquare(color, row, col));
+        }
+    }
+
+    return setup.str();
+}
@@ -0,0 +1,96 @@
+#ifndef __JR_SETUP_H__
+#define __JR_SETUP_H__
+
+//Search for the placement of the pieces on the first turn
+
+#include "board.h"
+#include "int64.h"
+#include "piece.h"
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//number of steps each candidate setup is searched to, which by default
+//covers gold's whole first move
+#define SETUP_SEARCH_DEPTH 4
+
+//number of candidates with the best static scores that are searched
+#define SETUP_NUM_SEARCHED 1024
+
+//default number of seconds the setup search may take
+#define SETUP_SEARCH_TIME 5.0
+
+//size of the hash tables of each thread's search in bytes
+#define SETUP_SEARCH_HASH_BYTES (4 * 1024 * 1024)
+
+//setup played for the opponent when it isn't known yet, which is the setup
+//this bot used to always play
+#define SETUP_DEFAULT_SILVER "ra8 rb8 rc8 dd8 de8 rf8 rg8 rh8 " \
+                             "ra7 hb7 cc7 md7 ee7 cf7 hg7 rh7"
+
+using namespace std;
+
+//Parameters of the setups that are tried. The elephant and camel go on the
+//front row, one on the strong column and the other on the column mirroring
+//it on the other half of the board. The rest of each half gets a horse, a
+//dog, a cat and four rabbits in every possible arrangement. If mirror is
+//set, the right half is always the mirror image of the left half.
+class SetupTemplate
+{
+    public:
+    SetupTemplate()
+    {
+        strongCol = 3;
+        mirror = false;
+    }
+
+    unsigned char strongCol; //column from 0 to 3 of the left half the
+                             //elephant or camel goes on
+    bool mirror;             //whether the halves mirror each other
+};
+
+//One setup being tried. The pieces are given by type, indexed by row from
+//the back row and by column in the player's own perspective.
+class SetupCandidate
+{
+    public:
+    unsigned char types[2][8]; //type of piece on each square of the setup
+    short staticScore;         //static score for the player setting up
+    short searchScore;         //searched score for the player setting up
+    bool searched;             //whether the search got to this candidate
+};
+
+//Scores setups from the template against the opponent's setup, or the
+//default setup if the opponent hasn't set up yet. Every candidate is scored
+//with the static eval, and the best ones are then searched in parallel until
+//the time runs out.
+class SetupSearch
+{
+    public:
+    SetupSearch(string evalWeightFile, int numThreads);
+
+    string findSetup(Board& board, double seconds, ostream& log);
+
+    SetupTemplate setupTemplate; //template the candidates come from
+    int depth;                   //number of steps each candidate is searched
+
+    private:
+    void genCandidates(vector<SetupCandidate>& candidates);
+    void placeSetup(Board& board, SetupCandidate& candidate,
+                    unsigned char color);
+    void scoreStatic(Board base, unsigned char color,
+                     vector<SetupCandidate>& candidates, int thread);
+    void scoreSearch(Board base, unsigned char color,
+                     vector<SetupCandidate>& candidates,
+                     unsigned int numSearched, double seconds);
+    string setupString(SetupCandidate& candidate, unsigned char color);
+
+    string evalWeightFile;   //weights each thread's eval loads
+    int numThreads;          //number of threads to score with
+
+    //next candidate to be searched by any thread
+    atomic<unsigned int> nextCandidate;
+};
+
+#endif
@@ -1,5 +1,6 @@
 #include "error.h"
 #include "int64.h"
+#include "square.h"
 #include <assert.h>
 #include <ctype.h>
 #include <string>
@@ -12,24 +13,33 @@ using namespace std;
 //////////////////////////////////////////////////////////////////////////////
 unsigned char squareFromString(string squareString)
 {
-    if (squareString.length() != 2)
+    return squareFromChars(squareString.data(), squareString.length());
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Same as squareFromString, but reads the square from the given number of
+//characters without copying them
+//////////////////////////////////////////////////////////////////////////////
+unsigned char squareFromChars(const char* squareChars, int length)
+{
+    if (length != 2)
     {
         Error error;
-        error << "From squareFromString(string)\n"
+        error << "From squareFromChars(const char*, int)\n"
               << "String must be 2 characters\n"
-              << "Got: " << squareString << '\n';
+              << "Got: " << string(squareChars, length) << '\n';
         throw error;
     }
 
-    int x = squareString[0] - 'a';
-    int y = 8 - (squareString[1] - '0');
+    int x = squareChars[0] - 'a';
+    int y = 8 - (squareChars[1] - '0');
 
     if (x < 0 || x > 7 || y < 0 || y > 7)
     {
         Error error;
-        error << "From squareFromString(string)\n"
+        error << "From squareFromChars(const char*, int)\n"
               << "Invalid square\n"
-              << "Got " << squareString << "\n";
+              << "Got " << string(squareChars, length) << "\n";
         throw error;
     }
     
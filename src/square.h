@@ -18,6 +18,7 @@ using namespace std;
 //functions to convert to/from ascii representations to internal
 //representations
 unsigned char squareFromString(string squareString);
+unsigned char squareFromChars(const char* squareChars, int length);
 string        stringFromSquare(unsigned char index);
 
 //functions to extract/set attributes of pieces  
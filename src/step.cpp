@@ -18,13 +18,22 @@ using namespace std;
 //////////////////////////////////////////////////////////////////////////////
 void Step :: fromString(string str)
 {
-    if (str.length() != 4  || !isalpha(str[0]) || !isalpha(str[1]) 
+    fromChars(str.data(), str.length());
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Same as fromString, but reads the step from the given number of characters
+//without copying them
+//////////////////////////////////////////////////////////////////////////////
+void Step :: fromChars(const char* str, int length)
+{
+    if (length != 4  || !isalpha(str[0]) || !isalpha(str[1]) 
     || !isdigit(str[2]) || !isalpha(str[3]))
     {
         Error error;
-        error << "From Step :: fromString(string str)\n";
+        error << "From Step :: fromChars(const char*, int)\n";
         error << "Invalid Format!\n";
-        error << "Got: " << str << '\n';
+        error << "Got: " << string(str, length) << '\n';
         
         throw error;
     }
@@ -33,9 +42,7 @@ void Step :: fromString(string str)
     unsigned char piece = pieceFromChar(str[0]);
     
     //read the position moving from
-    stringstream squareStringStream;
-    squareStringStream << str[1] << str[2];
-    unsigned int from = squareFromString(squareStringStream.str());
+    unsigned int from = squareFromChars(str + 1, 2);
 
     //read the last character for move type
     bool goingOffBoard = false;
@@ -95,22 +102,23 @@ void Step :: fromString(string str)
         Error error;
         if (goingOffBoard)
         {
-            error << "From Step :: fromString(string str)\n"
+            error << "From Step :: fromChars(const char*, int)\n"
                   << "Illegal Move. Piece moves off board\n"
-                  << "Got " << str << '\n';
+                  << "Got " << string(str, length) << '\n';
         }
         else if (illegalCapture)
         {
-            error << "From Step :: fromString(string str)\n"
+            error << "From Step :: fromChars(const char*, int)\n"
                   << "Invalid capture from non-trap square\n"
-                  << "Got " << str << '\n';
+                  << "Got " << string(str, length) << '\n';
 
         }
         else
         {
-            error << "From Step :: fromString(string str)\n"
+            error << "From Step :: fromChars(const char*, int)\n"
                   << "Invalid move type character\n"
-                  << "Got " << str[3] << " from " << str << '\n';
+                  << "Got " << str[3] << " from " << string(str, length)
+                  << '\n';
         }
 
         throw error;
@@ -157,22 +165,6 @@ string Step :: toString()
     return stepStream.str();
 }
 
-//////////////////////////////////////////////////////////////////////////////
-//Constructor. Sets the combo to be the empty combo
-//////////////////////////////////////////////////////////////////////////////
-StepCombo :: StepCombo()
-{
-    reset();
-}
-
-//////////////////////////////////////////////////////////////////////////////
-//Deconstructor. Does nothing.
-//////////////////////////////////////////////////////////////////////////////
-StepCombo :: ~StepCombo()
-{
-
-}
-
 //////////////////////////////////////////////////////////////////////////////
 //returns a string representing this combo
 //////////////////////////////////////////////////////////////////////////////
@@ -197,29 +189,42 @@ string StepCombo :: toString()
 //////////////////////////////////////////////////////////////////////////////
 void StepCombo :: fromString(string s)
 {
-    stringstream stepStream;
-    stepStream.str(s);
+    fromChars(s.data(), s.data() + s.length());
+}
 
+//////////////////////////////////////////////////////////////////////////////
+//Same as fromString, but reads the steps from the characters in between
+//begin and end without copying them
+//////////////////////////////////////////////////////////////////////////////
+void StepCombo :: fromChars(const char* begin, const char* end)
+{
     reset();
-    while (stepStream.good())
+    while (true)
     {
-        string word;
-        stepStream >> word;
+        //find the next whitespace separated word
+        while (begin < end && isspace(*begin))
+            ++begin;
 
-        if (stepStream.fail())
+        const char* wordEnd = begin;
+        while (wordEnd < end && !isspace(*wordEnd))
+            ++wordEnd;
+
+        if (wordEnd == begin)
             break;
 
         if (numSteps >= 8)
         {
             Error error;
-            error << "From StepCombo :: fromString(string str)\n"
+            error << "From StepCombo :: fromChars(const char*, const char*)\n"
                   << "Too many steps, already got " << toString() << "\n";
             throw error;
         }
 
         Step step;
-        step.fromString(word);
+        step.fromChars(begin, wordEnd - begin);
         addStep(step);
+
+        begin = wordEnd;
     }
 }
 
@@ -366,14 +371,4 @@ RawMove StepCombo :: getRawMove()
     else
         return RawMove(2, getFrom1(), getTo1(), getFrom2());
 }
-
-//////////////////////////////////////////////////////////////////////////////
-//resets this combo to a blank combo
-//////////////////////////////////////////////////////////////////////////////
-void StepCombo :: reset()
-{
-    numSteps = 0;
-    stepCost = 0;
-    score = 0;
-}
     
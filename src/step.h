@@ -13,6 +13,7 @@ class Step
 {
     public:
     void fromString(string str);
+    void fromChars(const char* str, int length);
     string toString();
 
     //////////////////////////////////////////////////////////////////////////
@@ -71,22 +72,29 @@ class Step
     //bits 4 - 9:   describes the source square
     //bits 10 - 15: describes the destination square, set to be the same
     //              as the source square to designate a capture
-    unsigned int data; 
+    unsigned short data; 
 
     
 };
 
 //representation of a combo of steps. Used for sets of steps that cannot be
 //broken down into its parts (such as pushes and pulls), and perhaps useful
-//macro movements of pieces
+//macro movements of pieces. Move lists hold a lot of these and copy them
+//around, so a combo is kept to 24 bytes and can be copied as plain memory.
 class StepCombo
 {
     public:
-    StepCombo();
-    ~StepCombo();
+    //////////////////////////////////////////////////////////////////////////
+    //Constructor. Sets the combo to be the empty combo
+    //////////////////////////////////////////////////////////////////////////
+    StepCombo()
+    {
+        reset();
+    }
 
     string toString();
     void fromString(string s);
+    void fromChars(const char* begin, const char* end);
 
     void addStep(Step step);
     void addCombo(StepCombo& combo);
@@ -102,7 +110,15 @@ class StepCombo
 
     RawMove getRawMove();
 
-    void reset();
+    //////////////////////////////////////////////////////////////////////////
+    //resets this combo to a blank combo
+    //////////////////////////////////////////////////////////////////////////
+    void reset()
+    {
+        numSteps = 0;
+        stepCost = 0;
+        score = 0;
+    }
     
     //////////////////////////////////////////////////////////////////////////
     //Generate a combo that will pass the rest of the turn
@@ -152,7 +168,7 @@ class StepCombo
                    //can be larger than the actual number of steps stored
                    //Use the variable numSteps to find the actual number.
 
-    unsigned int numSteps;   //number of total steps, including captures.
+    unsigned char numSteps;  //number of total steps, including captures.
     
     unsigned short stepCost; //number of actual steps that this combo takes,
                              //note that captures do not count.
@@ -0,0 +1,118 @@
+#include "telemetry.h"
+#include "int64.h"
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//////////////////////////////////////////////////////////////////////////////
+//Constructor, starts a record with its type as the first field
+//////////////////////////////////////////////////////////////////////////////
+TelemetryRecord :: TelemetryRecord(string type)
+{
+    numFields = 0;
+    text << "{";
+    addName("type");
+    addString(type);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Adds a field with a number value
+//////////////////////////////////////////////////////////////////////////////
+void TelemetryRecord :: add(string name, Int64 value)
+{
+    addName(name);
+    text << value;
+}
+
+void TelemetryRecord :: add(string name, int value)
+{
+    addName(name);
+    text << value;
+}
+
+void TelemetryRecord :: add(string name, unsigned int value)
+{
+    addName(name);
+    text << value;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Adds a field with a fractional value, to a few decimal places
+//////////////////////////////////////////////////////////////////////////////
+void TelemetryRecord :: add(string name, double value)
+{
+    addName(name);
+    text << fixed << setprecision(4) << value;
+    text.unsetf(ios::fixed);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Adds a field with a string value
+//////////////////////////////////////////////////////////////////////////////
+void TelemetryRecord :: add(string name, string value)
+{
+    addName(name);
+    addString(value);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Adds a field with a list of strings
+//////////////////////////////////////////////////////////////////////////////
+void TelemetryRecord :: add(string name, const vector<string>& values)
+{
+    addName(name);
+    text << "[";
+    for (unsigned int i = 0; i < values.size(); i++)
+    {
+        if (i > 0)
+            text << ",";
+        addString(values[i]);
+    }
+    text << "]";
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Writes the record as one line and flushes it, so a record is never left
+//half written
+//////////////////////////////////////////////////////////////////////////////
+void TelemetryRecord :: write(ostream& out)
+{
+    out << text.str() << "}\n";
+    out.flush();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Writes the name of the next field, after a comma if it isn't the first
+//////////////////////////////////////////////////////////////////////////////
+void TelemetryRecord :: addName(string name)
+{
+    if (numFields > 0)
+        text << ",";
+    numFields++;
+    addString(name);
+    text << ":";
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Writes a string in quotes, escaping the characters JSON needs escaped
+//////////////////////////////////////////////////////////////////////////////
+void TelemetryRecord :: addString(string value)
+{
+    text << "\"";
+    for (unsigned int i = 0; i < value.length(); i++)
+    {
+        char c = value[i];
+        if (c == '"' || c == '\\')
+            text << "\\" << c;
+        else if ((unsigned char)c < 0x20)
+            text << "\\u" << hex << setw(4) << setfill('0') << (int)c
+                 << dec << setfill(' ');
+        else
+            text << c;
+    }
+    text << "\"";
+}
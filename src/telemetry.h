@@ -0,0 +1,39 @@
+#ifndef __JR_TELEMETRY_H__
+#define __JR_TELEMETRY_H__
+
+//Telemetry records, written as one JSON object per line so that a lot of
+//them can be collected and read by other tools
+
+#include "int64.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//One record being built. Fields are added in order and the record is
+//written as a single line once it is complete.
+class TelemetryRecord
+{
+    public:
+    TelemetryRecord(string type);
+
+    void add(string name, Int64 value);
+    void add(string name, int value);
+    void add(string name, unsigned int value);
+    void add(string name, double value);
+    void add(string name, string value);
+    void add(string name, const vector<string>& values);
+
+    void write(ostream& out);
+
+    private:
+    void addName(string name);
+    void addString(string value);
+
+    stringstream text; //the fields added so far
+    int numFields;     //number of fields added so far
+};
+
+#endif
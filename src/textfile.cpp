@@ -0,0 +1,201 @@
+#include "textfile.h"
+#include "int64.h"
+#include <ctype.h>
+#include <fcntl.h>
+#include <string.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+//////////////////////////////////////////////////////////////////////////////
+//Takes the first word off the front of the range, skipping any whitespace
+//before it. Returns false, leaving the range empty, if there are no more
+//words.
+//////////////////////////////////////////////////////////////////////////////
+bool TextRange :: nextWord(TextRange& word)
+{
+    while (begin < end && isspace(*begin))
+        ++begin;
+
+    word.begin = begin;
+    while (begin < end && !isspace(*begin))
+        ++begin;
+    word.end = begin;
+
+    return word.begin != word.end;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Takes the first line off the front of the range. The line doesn't include
+//the line break, or the carriage return of windows line breaks. Returns
+//false if the range is empty.
+//////////////////////////////////////////////////////////////////////////////
+bool TextRange :: nextLine(TextRange& line)
+{
+    if (begin >= end)
+        return false;
+
+    line.begin = begin;
+    const char* lineEnd = (const char*)memchr(begin, '\n', end - begin);
+    if (lineEnd == 0)
+    {
+        lineEnd = end;
+        begin = end;
+    }
+    else
+    {
+        begin = lineEnd + 1;
+    }
+
+    if (lineEnd > line.begin && lineEnd[-1] == '\r')
+        --lineEnd;
+    line.end = lineEnd;
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Returns true if the range holds exactly the text given
+//////////////////////////////////////////////////////////////////////////////
+bool TextRange :: equals(const char* text)
+{
+    int textLength = strlen(text);
+    return textLength == end - begin && memcmp(begin, text, textLength) == 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Returns true if the range has nothing but whitespace
+//////////////////////////////////////////////////////////////////////////////
+bool TextRange :: isBlank()
+{
+    for (const char* c = begin; c < end; c++)
+    {
+        if (!isspace(*c))
+            return false;
+    }
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Returns a copy of the range as a string, for error messages and such
+//////////////////////////////////////////////////////////////////////////////
+string TextRange :: toString()
+{
+    return string(begin, end);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Constructor, starts with no file
+//////////////////////////////////////////////////////////////////////////////
+TextFile :: TextFile()
+{
+    data = 0;
+    size = 0;
+    pos = 0;
+    mapped = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Deconstructor, closes the file
+//////////////////////////////////////////////////////////////////////////////
+TextFile :: ~TextFile()
+{
+    close();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Opens a file to read from the start. Returns false if it couldn't be
+//opened.
+//////////////////////////////////////////////////////////////////////////////
+bool TextFile :: open(string filename)
+{
+    close();
+
+    int file = ::open(filename.c_str(), O_RDONLY);
+    if (file < 0)
+        return false;
+
+    struct stat fileStat;
+    if (fstat(file, &fileStat) != 0)
+    {
+        ::close(file);
+        return false;
+    }
+
+    if (S_ISREG(fileStat.st_mode))
+    {
+        size = fileStat.st_size;
+        if (size > 0)
+        {
+            mapped = mmap(0, size, PROT_READ, MAP_PRIVATE, file, 0);
+            if (mapped == MAP_FAILED)
+            {
+                mapped = 0;
+                size = 0;
+                ::close(file);
+                return false;
+            }
+
+            data = (const char*)mapped;
+        }
+    }
+    else
+    {
+        //can't be mapped, so read until the end
+        char chunk[4096];
+        ssize_t numRead;
+        while ((numRead = read(file, chunk, sizeof(chunk))) > 0)
+            buffer.insert(buffer.end(), chunk, chunk + numRead);
+
+        size = buffer.size();
+        data = buffer.empty() ? 0 : &buffer[0];
+    }
+
+    ::close(file);
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Closes the file
+//////////////////////////////////////////////////////////////////////////////
+void TextFile :: close()
+{
+    if (mapped != 0)
+        munmap(mapped, size);
+
+    mapped = 0;
+    buffer.clear();
+    data = 0;
+    size = 0;
+    pos = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Sets the range to the next line, not including the line break. Returns
+//false at the end of the file.
+//////////////////////////////////////////////////////////////////////////////
+bool TextFile :: nextLine(TextRange& line)
+{
+    TextRange rest = getText();
+    rest.begin += pos;
+    if (!rest.nextLine(line))
+        return false;
+
+    pos = rest.begin - data;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Returns a range over the whole file, so it can be read in parts
+//////////////////////////////////////////////////////////////////////////////
+TextRange TextFile :: getText()
+{
+    TextRange text;
+    text.begin = data;
+    text.end = data + size;
+    return text;
+}
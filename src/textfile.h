@@ -0,0 +1,88 @@
+#ifndef __JR_TEXTFILE_H__
+#define __JR_TEXTFILE_H__
+
+//reading of text files in place, without copying lines or words
+
+#include "int64.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//A run of characters inside a TextFile. Words can be taken off the front
+//of the range one at a time, and each word is itself a range pointing into
+//the same characters, so nothing is ever copied.
+class TextRange
+{
+    public:
+    //////////////////////////////////////////////////////////////////////////
+    //Constructor, starts as an empty range
+    //////////////////////////////////////////////////////////////////////////
+    TextRange()
+    {
+        begin = 0;
+        end = 0;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //Constructor, covers the characters from begin up to end
+    //////////////////////////////////////////////////////////////////////////
+    TextRange(const char* begin, const char* end)
+    {
+        this->begin = begin;
+        this->end = end;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //Returns the number of characters in the range
+    //////////////////////////////////////////////////////////////////////////
+    int length()
+    {
+        return end - begin;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //Returns the character at that index in the range, or a space if the
+    //index is past the end of the range
+    //////////////////////////////////////////////////////////////////////////
+    char at(int index)
+    {
+        return index < end - begin ? begin[index] : ' ';
+    }
+
+    bool nextWord(TextRange& word);
+    bool nextLine(TextRange& line);
+    bool equals(const char* text);
+    bool isBlank();
+    string toString();
+
+    const char* begin; //first character in the range
+    const char* end;   //one past the last character in the range
+};
+
+//A whole text file in memory, read a line at a time. Regular files are
+//mapped straight from the file, and anything else (such as a pipe) is read
+//into a buffer.
+class TextFile
+{
+    public:
+    TextFile();
+    ~TextFile();
+
+    bool open(string filename);
+    void close();
+    bool nextLine(TextRange& line);
+    TextRange getText();
+
+    private:
+    TextFile(const TextFile& copy);
+    TextFile& operator=(const TextFile& copy);
+
+    const char* data;     //characters of the whole file
+    Int64 size;           //number of characters
+    Int64 pos;            //index of the start of the next line
+    void* mapped;         //start of the mapping if the file was mapped
+    vector<char> buffer;  //characters if the file was read instead
+};
+
+#endif
@@ -152,25 +152,47 @@ class TranspositionTable
 {
     public:
     //////////////////////////////////////////////////////////////////////////
-    //sets the table size to handle all keys that have the specified number of 
-    //bits. That is the table is set to 2 ^ (numbits) entries. Also sets the
-    //hash mask to enforce that keys are limited to that number of bits
+    //sets the table to have the specified number of entries, which need not
+    //be a power of 2
     //////////////////////////////////////////////////////////////////////////
-    void setHashKeySize(unsigned int numBits)
+    void setNumEntries(Int64 numEntries)
     {
-        hashes.init(Int64FromIndex(numBits)); 
-        hashMask = Int64LowerBitsFilled(numBits);        
+        hashes.init(numEntries);
     }
 
     //////////////////////////////////////////////////////////////////////////
-    //Resets every entry
+    //Takes the entries from a file written by write(), at that offset in the
+    //file. Returns false, leaving the table with no entries, if the file
+    //doesn't have that many entries.
+    //////////////////////////////////////////////////////////////////////////
+    bool mapFile(string filename, Int64 offset, Int64 numEntries)
+    {
+        return hashes.mapFile(filename, offset, numEntries);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //Writes every entry to the stream
+    //////////////////////////////////////////////////////////////////////////
+    void write(ostream& out)
+    {
+        hashes.write(out);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //Returns the number of entries
+    //////////////////////////////////////////////////////////////////////////
+    Int64 getNumEntries()
+    {
+        return hashes.getNumEntries();
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //Resets every entry. An entry that is all zero is reset, so this just
+    //zeroes the whole table
     //////////////////////////////////////////////////////////////////////////
     void reset()
     {
-        for (int i = 0; i < hashes.getNumEntries(); i++)
-        {
-            hashes.getEntry(i).reset();
-        }
+        hashes.clear();
     }
 
     //////////////////////////////////////////////////////////////////////////
@@ -178,8 +200,8 @@ class TranspositionTable
     //////////////////////////////////////////////////////////////////////////
     bool hasValidEntry(Int64 hash)
     {
-        return hashes.getEntry(hash & hashMask).isFilled() &&
-               hashes.getEntry(hash & hashMask).getHash() == hash;
+        return hashes.getEntry(hashes.getIndex(hash)).isFilled() &&
+               hashes.getEntry(hashes.getIndex(hash)).getHash() == hash;
     }
 
     //////////////////////////////////////////////////////////////////////////
@@ -189,7 +211,7 @@ class TranspositionTable
     //////////////////////////////////////////////////////////////////////////
     TranspositionEntry& getEntry(Int64 hash)
     {
-        return hashes.getEntry(hash & hashMask);
+        return hashes.getEntry(hashes.getIndex(hash));
     }
 
     //////////////////////////////////////////////////////////////////////////
@@ -200,7 +222,7 @@ class TranspositionTable
     void setEntry(Int64 hash, unsigned char scoreType, short score, 
                   unsigned char depth, RawMove bestMove)
     {
-        TranspositionEntry& entry = hashes.getEntry(hash & hashMask);
+        TranspositionEntry& entry = hashes.getEntry(hashes.getIndex(hash));
         if (!entry.isFilled() || depth >= entry.getDepth())
         {
             entry.set(true, scoreType, score, depth, bestMove.numSteps,
@@ -208,12 +230,25 @@ class TranspositionTable
         }
     }
     
+    //////////////////////////////////////////////////////////////////////////
+    //Starts loading the entry for that hash key into the cache
+    //////////////////////////////////////////////////////////////////////////
+    void prefetch(Int64 hash)
+    {
+        hashes.prefetch(hashes.getIndex(hash));
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //Returns a description of the memory the table was given
+    //////////////////////////////////////////////////////////////////////////
+    string getMemDescription()
+    {
+        return hashes.getMemDescription();
+    }
+
     private:
     //Internal hash table to keep the entries
     HashTable<TranspositionEntry> hashes;
-
-    //Mask to limit bits on accessing hashes
-    Int64 hashMask;
 };
 
 #endif
@@ -0,0 +1,367 @@
+#include "treelog.h"
+#include "board.h"
+#include "error.h"
+#include "int64.h"
+#include "rawmove.h"
+#include "square.h"
+#include "step.h"
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+//names of the reasons a node or move returned its score
+static const char* nodeReasonNames[TREE_NODE_NUM_REASONS] =
+{
+    "already won", "scored at the horizon", "scored at beta before the"
+    " last step", "passed with no steps left", "cut by the transposition"
+    " table", "beta cutoff", "no moves", "failed low", "exact score"
+};
+
+static const char* moveReasonNames[TREE_MOVE_NUM_REASONS] =
+{
+    "searched", "position already searched at this ply", "turn ended where"
+    " it started", "goal", "turn ended without improving the eval",
+    "third repetition of the game"
+};
+
+//////////////////////////////////////////////////////////////////////////////
+//Constructor, with the size of the buffer in bytes, which always holds at
+//least one record
+//////////////////////////////////////////////////////////////////////////////
+SearchTreeLog :: SearchTreeLog(Int64 bufferBytes)
+{
+    Int64 numRecords = bufferBytes / sizeof(TreeLogRecord);
+    records.resize(numRecords > 0 ? numRecords : 1);
+    numAdded = 0;
+    memset(&header, 0, sizeof(header));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Empties the buffer to record a new search of the board given
+//////////////////////////////////////////////////////////////////////////////
+void SearchTreeLog :: start(Board& board, int rootPly)
+{
+    numAdded = 0;
+    memset(&header, 0, sizeof(header));
+    header.magic = TREE_LOG_MAGIC;
+    header.version = TREE_LOG_VERSION;
+    board.encode(header.root);
+    header.rootPly = rootPly;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Returns the record to write next, which is the oldest one once the buffer
+//is full
+//////////////////////////////////////////////////////////////////////////////
+TreeLogRecord& SearchTreeLog :: nextRecord()
+{
+    TreeLogRecord& record = records[numAdded % records.size()];
+    numAdded++;
+    record = TreeLogRecord();
+    return record;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Records the score a node returned, and why
+//////////////////////////////////////////////////////////////////////////////
+void SearchTreeLog :: addNode(unsigned int node, Int64 hash, int ply,
+                              int depth, short alpha, short beta, short score,
+                              unsigned char reason, RawMove move)
+{
+    TreeLogRecord& record = nextRecord();
+    record.kind = TREE_LOG_NODE;
+    record.hash = hash;
+    record.node = node;
+    record.ply = ply;
+    record.depth = depth;
+    record.alpha = alpha;
+    record.beta = beta;
+    record.score = score;
+    record.reason = reason;
+    record.move = move;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Records the score a move from the node being searched at the ply returned,
+//in the perspective of the player that played it, and why
+//////////////////////////////////////////////////////////////////////////////
+void SearchTreeLog :: addMove(int ply, RawMove move, unsigned int child,
+                              short alpha, short beta, short score,
+                              unsigned char reason)
+{
+    TreeLogRecord& record = nextRecord();
+    record.kind = TREE_LOG_MOVE;
+    record.node = nodeAtPly[ply];
+    record.child = child;
+    record.ply = ply;
+    record.alpha = alpha;
+    record.beta = beta;
+    record.score = score;
+    record.reason = reason;
+    record.move = move;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Records the end of an iteration
+//////////////////////////////////////////////////////////////////////////////
+void SearchTreeLog :: addIteration(int depth, short score,
+                                   unsigned int numNodes)
+{
+    TreeLogRecord& record = nextRecord();
+    record.kind = TREE_LOG_ITERATION;
+    record.node = numNodes;
+    record.depth = depth;
+    record.score = score;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Writes the records kept to a file, oldest first
+//////////////////////////////////////////////////////////////////////////////
+void SearchTreeLog :: save(string filename)
+{
+    ofstream out(filename.c_str(), ios::out | ios::binary | ios::trunc);
+    if (!out.is_open())
+    {
+        Error error;
+        error << "From SearchTreeLog :: save(string)\n"
+              << "Could not open file: " << filename << "\n";
+        throw error;
+    }
+
+    Int64 numKept = numAdded;
+    if (numKept > records.size())
+        numKept = records.size();
+    header.numRecords = numKept;
+    header.numDropped = numAdded - numKept;
+    out.write((const char*)&header, sizeof(header));
+
+    //once the buffer has wrapped, the oldest record is the next one to be
+    //replaced
+    Int64 first = numAdded - numKept;
+    for (Int64 i = first; i < numAdded; i++)
+    {
+        out.write((const char*)&records[i % records.size()],
+                  sizeof(TreeLogRecord));
+    }
+    out.close();
+
+    if (!out)
+    {
+        Error error;
+        error << "From SearchTreeLog :: save(string)\n"
+              << "Could not write file: " << filename << "\n";
+        throw error;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Finds the move of the board that has the raw move given. Returns false if
+//there is none.
+//////////////////////////////////////////////////////////////////////////////
+static bool findMove(Board& board, RawMove move, StepCombo& combo)
+{
+    vector<StepCombo> combos;
+    board.genMoves(combos);
+    for (unsigned int i = 0; i < combos.size(); i++)
+    {
+        if (combos[i].getRawMove() == move)
+        {
+            combo = combos[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Returns the move in the usual notation if it can be played on the board,
+//and as its squares otherwise
+//////////////////////////////////////////////////////////////////////////////
+static string moveText(Board& board, RawMove move)
+{
+    StepCombo combo;
+    if (findMove(board, move, combo))
+        return combo.toString();
+
+    string text = stringFromSquare(move.from1) + "-"
+                  + stringFromSquare(move.to1);
+    if (move.numSteps == 2)
+        text += " " + stringFromSquare(move.from2) + "-"
+                + stringFromSquare(move.from1);
+    return text;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Writes a node or move record: its window, score and reason, and the move
+//as it would be played on the board given
+//////////////////////////////////////////////////////////////////////////////
+static void writeRecord(TreeLogRecord& record, Board& board, ostream& out)
+{
+    out << "[" << setw(6) << record.alpha << "," << setw(6) << record.beta
+        << "] score " << setw(6) << record.score << " ";
+
+    if (record.kind == TREE_LOG_MOVE)
+    {
+        out << setw(16) << left << moveText(board, record.move) << right
+            << " " << (record.reason < TREE_MOVE_NUM_REASONS ?
+                       moveReasonNames[record.reason] : "?");
+    }
+    else
+    {
+        out << "depth " << (int)record.depth << ", "
+            << (record.reason < TREE_NODE_NUM_REASONS ?
+                nodeReasonNames[record.reason] : "?");
+        if (record.reason == TREE_NODE_BETA_CUT ||
+            record.reason == TREE_NODE_EXACT ||
+            record.reason == TREE_NODE_FAIL_LOW ||
+            record.reason == TREE_NODE_TT_CUTOFF)
+            out << ", best " << moveText(board, record.move);
+    }
+    out << "\n";
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Reads a tree log file and writes what it says about the search. Without a
+//move, it lists every root move of the last iteration recorded. With a
+//root move in the usual notation, it shows that move in every iteration,
+//with the node searched after it and the moves tried from there, to see
+//why it scored what it did.
+//////////////////////////////////////////////////////////////////////////////
+void queryTreeLog(string filename, string move, ostream& out)
+{
+    ifstream in(filename.c_str(), ios::in | ios::binary);
+    TreeLogHeader header;
+    if (!in.read((char*)&header, sizeof(header)) ||
+        header.magic != TREE_LOG_MAGIC || header.version != TREE_LOG_VERSION)
+    {
+        Error error;
+        error << "From queryTreeLog(string, string, ostream&)\n"
+              << "Not a tree log file: " << filename << "\n";
+        throw error;
+    }
+
+    vector<TreeLogRecord> records(header.numRecords);
+    if (header.numRecords > 0 &&
+        !in.read((char*)&records[0], records.size() * sizeof(TreeLogRecord)))
+    {
+        Error error;
+        error << "From queryTreeLog(string, string, ostream&)\n"
+              << "Tree log file is cut short: " << filename << "\n";
+        throw error;
+    }
+
+    Board root;
+    root.genRandomHashes();
+    root.decode(header.root);
+
+    out << "Root position:\n" << root << "\n";
+    out << records.size() << " records, " << (int)header.numDropped
+        << " older records dropped\n";
+
+    //Nodes are recorded when they return, after the moves tried from them,
+    //so the root node ends each iteration just before its iteration record
+    unordered_map<unsigned int, unsigned int> nodeRecords;
+    vector<unsigned int> iterationEnds;
+    for (unsigned int i = 0; i < records.size(); i++)
+    {
+        if (records[i].kind == TREE_LOG_NODE)
+            nodeRecords[records[i].node] = i;
+        else if (records[i].kind == TREE_LOG_ITERATION)
+        {
+            iterationEnds.push_back(i);
+            out << "Iteration depth " << (int)records[i].depth << " score "
+                << records[i].score << " after " << records[i].node
+                << " nodes\n";
+        }
+    }
+    out << "\n";
+
+    if (iterationEnds.empty())
+        return;
+
+    //find the raw move of the root move asked about
+    RawMove wanted(0, ILLEGAL_SQUARE, ILLEGAL_SQUARE, ILLEGAL_SQUARE);
+    if (move != string(""))
+    {
+        vector<StepCombo> combos;
+        root.genMoves(combos);
+        for (unsigned int i = 0; i < combos.size(); i++)
+        {
+            if (combos[i].toString() == move)
+                wanted = combos[i].getRawMove();
+        }
+
+        if (wanted.numSteps == 0)
+        {
+            Error error;
+            error << "From queryTreeLog(string, string, ostream&)\n"
+                  << move << " is not a move of the root position\n";
+            throw error;
+        }
+    }
+
+    unsigned int first = 0;
+    for (unsigned int it = 0; it < iterationEnds.size(); it++)
+    {
+        unsigned int last = iterationEnds[it];
+
+        //without a move, only the last iteration is shown
+        if (move == string("") && it + 1 < iterationEnds.size())
+        {
+            first = last + 1;
+            continue;
+        }
+
+        out << "Depth " << (int)records[last].depth << ":\n";
+        for (unsigned int i = first; i < last; i++)
+        {
+            TreeLogRecord& record = records[i];
+            if (record.kind != TREE_LOG_MOVE ||
+                record.ply != header.rootPly)
+                continue;
+            if (move != string("") && !(record.move == wanted))
+                continue;
+
+            out << "  ";
+            writeRecord(record, root, out);
+
+            //show the node searched after the move and the moves tried
+            //from it
+            if (record.child == 0 || !nodeRecords.count(record.child))
+                continue;
+
+            TreeLogRecord& child = records[nodeRecords[record.child]];
+            Board after = root;
+            StepCombo combo;
+            if (findMove(root, record.move, combo))
+            {
+                after.playCombo(combo);
+                if (after.stepsLeft == 0)
+                    after.changeTurn();
+            }
+            out << "    node " << record.child << " ";
+            writeRecord(child, after, out);
+
+            if (move == string(""))
+                continue;
+
+            for (unsigned int j = first; j < last; j++)
+            {
+                if (records[j].kind == TREE_LOG_MOVE &&
+                    records[j].node == record.child)
+                {
+                    out << "      ";
+                    writeRecord(records[j], after, out);
+                }
+            }
+        }
+
+        first = last + 1;
+    }
+}
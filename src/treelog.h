@@ -0,0 +1,155 @@
+#ifndef __JR_TREELOG_H__
+#define __JR_TREELOG_H__
+
+//Recording of the nodes and moves of a search into a bounded buffer, which
+//can be saved to a binary file and queried afterward to see why the search
+//did what it did
+
+#include "board.h"
+#include "int64.h"
+#include "rawmove.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+//identifies a tree log file ("JRTL" read as little endian bytes), and the
+//version of its layout
+#define TREE_LOG_MAGIC   0x4C54524A
+#define TREE_LOG_VERSION 1
+
+//size of the buffer of records by default
+#define TREE_LOG_BYTES (64 * 1024 * 1024)
+
+//kinds of records
+#define TREE_LOG_NODE      0 //a node was searched
+#define TREE_LOG_MOVE      1 //a move was tried from a node
+#define TREE_LOG_ITERATION 2 //an iteration finished
+
+//reasons a node returned its score
+#define TREE_NODE_WIN        0 //the player to move has already won
+#define TREE_NODE_HORIZON    1 //scored by the tactical extension at the
+                               //horizon
+#define TREE_NODE_STAND_PAT  2 //the last step of the turn was scored at
+                               //beta already
+#define TREE_NODE_PASS       3 //no steps left, so the turn was passed
+#define TREE_NODE_TT_CUTOFF  4 //the transposition table entry closed the
+                               //window
+#define TREE_NODE_BETA_CUT   5 //a move scored at least beta
+#define TREE_NODE_NO_MOVES   6 //no moves could be generated
+#define TREE_NODE_FAIL_LOW   7 //no move raised alpha
+#define TREE_NODE_EXACT      8 //a move raised alpha without reaching beta
+#define TREE_NODE_NUM_REASONS 9
+
+//reasons a move returned its score
+#define TREE_MOVE_SEARCHED      0 //the node after the move was searched
+#define TREE_MOVE_SEARCH_REPEAT 1 //the position already occurred at this
+                                  //ply in the search
+#define TREE_MOVE_NO_CHANGE     2 //the turn ended in the position it
+                                  //started in
+#define TREE_MOVE_GOAL          3 //the move won the game
+#define TREE_MOVE_NO_GAIN       4 //the turn ended without improving the
+                                  //eval score
+#define TREE_MOVE_GAME_REPEAT   5 //the turn made a position occur for the
+                                  //third time in the game
+#define TREE_MOVE_NUM_REASONS   6
+
+using namespace std;
+
+//One node, move or iteration of a search. For a node, node is its id and
+//the window is the one it was searched with. For a move, node is the id of
+//the node it was played from and child is the id of the node searched after
+//it, or 0 if none was. For an iteration, depth and score are the
+//iteration's and node is the number of nodes searched so far.
+class TreeLogRecord
+{
+    public:
+    //////////////////////////////////////////////////////////////////////////
+    //Constructor, with every field zero, so a record's unused fields and
+    //padding are the same in every file
+    //////////////////////////////////////////////////////////////////////////
+    TreeLogRecord() : move(0, 0, 0, 0)
+    {
+        hash = 0;
+        node = 0;
+        child = 0;
+        alpha = 0;
+        beta = 0;
+        score = 0;
+        kind = 0;
+        reason = 0;
+        ply = 0;
+        depth = 0;
+        padding[0] = 0;
+        padding[1] = 0;
+    }
+
+    Int64 hash;           //hash of the node's position
+    unsigned int node;    //id of the node
+    unsigned int child;   //id of the node searched after a move
+    short alpha;          //window the node or move was searched with
+    short beta;
+    short score;          //score returned
+    unsigned char kind;   //TREE_LOG_NODE, TREE_LOG_MOVE or
+                          //TREE_LOG_ITERATION
+    unsigned char reason; //why the score was returned
+    unsigned char ply;
+    signed char depth;    //depth left
+    RawMove move;         //move of a move record, the best or cutoff move
+                          //of a node, if any
+    unsigned char padding[2];
+};
+
+//Start of a tree log file, which is followed by the records oldest first
+class TreeLogHeader
+{
+    public:
+    unsigned int magic;     //TREE_LOG_MAGIC
+    unsigned int version;   //TREE_LOG_VERSION
+    PackedBoard root;       //position searched
+    Int64 numRecords;       //number of records following
+    Int64 numDropped;       //number of older records that didn't fit
+    unsigned int rootPly;   //ply of the root node
+    unsigned int padding;
+};
+
+//Buffer of the records of one search. Once it is full, each new record
+//replaces the oldest one, so the last iterations are always kept.
+class SearchTreeLog
+{
+    public:
+    SearchTreeLog(Int64 bufferBytes);
+
+    void start(Board& board, int rootPly);
+
+    //////////////////////////////////////////////////////////////////////////
+    //Notes the node being searched at a ply, which moves tried at that ply
+    //are played from
+    //////////////////////////////////////////////////////////////////////////
+    void enterNode(int ply, unsigned int node)
+    {
+        if (ply >= (int)nodeAtPly.size())
+            nodeAtPly.resize(ply + 1);
+        nodeAtPly[ply] = node;
+    }
+
+    void addNode(unsigned int node, Int64 hash, int ply, int depth,
+                 short alpha, short beta, short score, unsigned char reason,
+                 RawMove move);
+    void addMove(int ply, RawMove move, unsigned int child, short alpha,
+                 short beta, short score, unsigned char reason);
+    void addIteration(int depth, short score, unsigned int numNodes);
+
+    void save(string filename);
+
+    private:
+    TreeLogRecord& nextRecord();
+
+    vector<TreeLogRecord> records; //the buffer
+    Int64 numAdded;                //records added since the start
+    vector<unsigned int> nodeAtPly; //node being searched at each ply
+    TreeLogHeader header;          //header of the search being recorded
+};
+
+void queryTreeLog(string filename, string move, ostream& out);
+
+#endif
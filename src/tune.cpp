@@ -0,0 +1,352 @@
+#include "tune.h"
+#include "board.h"
+#include "eval.h"
+#include "error.h"
+#include "gamerecord.h"
+#include "int64.h"
+#include "piece.h"
+#include "square.h"
+#include "step.h"
+#include "textfile.h"
+#include <iostream>
+#include <math.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+//////////////////////////////////////////////////////////////////////////////
+//Constructor. Starts the tuning from the weights currently in the eval,
+//and sets up the boards each thread uses.
+//////////////////////////////////////////////////////////////////////////////
+Tuner :: Tuner(Eval& eval, int numThreads) : eval(eval)
+{
+    if (numThreads < 1)
+        numThreads = 1;
+    this->numThreads = numThreads;
+
+    for (int type = 0; type < MAX_TYPES; type++)
+    {
+        for (int num = 0; num < 9; num++)
+        {
+            params[TUNE_MATERIAL_PARAMS + type * 9 + num] =
+                                          eval.materialWeights[type][num];
+        }
+
+        for (int row = 0; row < 8; row++)
+        {
+            for (int col = 0; col < 4; col++)
+            {
+                params[TUNE_POS_PARAMS + type * 32 + row * 4 + col] =
+                                  eval.posWeights[GOLD][type][row * 8 + col];
+            }
+        }
+    }
+
+    for (int type = 0; type < MAX_TYPES - 1; type++)
+    {
+        for (int num = 0; num < 9; num++)
+        {
+            params[TUNE_FROZEN_PARAMS + type * 9 + num] =
+                                            eval.frozenWeights[type][num];
+        }
+    }
+
+    //The threads all evaluate with the same eval through evalBatch, which
+    //only reads the weights, but each needs its own boards
+    readBoard.genRandomHashes();
+    threadBoards.assign(numThreads, vector<Board>(EVAL_BATCH_SIZE));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Runs gradient descent over the data file for the specified number of
+//passes. The weights are updated after each chunk of samples read, and
+//written to the eval being tuned.
+//////////////////////////////////////////////////////////////////////////////
+void Tuner :: tune(string dataFile, int numEpochs, double learningRate,
+                   ostream& log)
+{
+    vector<TuneSample> samples;
+    samples.reserve(TUNE_CHUNK_SIZE);
+
+    for (int epoch = 1; epoch <= numEpochs; epoch++)
+    {
+        TextFile in;
+
+        if (!in.open(dataFile))
+        {
+            Error error;
+            error << "From Tuner :: tune\n"
+                  << "Could not open file: "
+                  << dataFile << "\n";
+            throw error;
+        }
+
+        GameRecordReader reader(in.getText());
+
+        double totalLoss = 0;
+        Int64 numSamples = 0;
+
+        while (readSamples(reader, samples) > 0)
+        {
+            double gradient[TUNE_NUM_PARAMS];
+            for (int i = 0; i < TUNE_NUM_PARAMS; i++)
+                gradient[i] = 0;
+
+            totalLoss += processChunk(samples, gradient);
+            numSamples += samples.size();
+
+            //step the weights against the average gradient over the chunk
+            for (int i = 0; i < TUNE_NUM_PARAMS; i++)
+            {
+                params[i] -= learningRate * gradient[i] / samples.size();
+            }
+
+            writeParamsToEval();
+        }
+
+        in.close();
+
+        log << "Epoch " << epoch << ": " << numSamples << " positions, "
+            << "average loss " << (numSamples ? totalLoss / numSamples : 0)
+            << endl;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Evaluates all the samples in the chunk with the current weights, split
+//over all threads. The gradient of the total loss is added onto the
+//gradient array given, and the total loss is returned.
+//////////////////////////////////////////////////////////////////////////////
+double Tuner :: processChunk(vector<TuneSample>& samples, double* gradient)
+{
+    vector<vector<double> > threadGradients(numThreads,
+                                            vector<double>(TUNE_NUM_PARAMS));
+    vector<double> threadLosses(numThreads);
+    vector<thread> threads;
+
+    unsigned int perThread = samples.size() / numThreads + 1;
+    for (int t = 0; t < numThreads; t++)
+    {
+        unsigned int first = t * perThread;
+        unsigned int last  = first + perThread;
+        if (first > samples.size())
+            first = samples.size();
+        if (last > samples.size())
+            last = samples.size();
+
+        threads.push_back(thread(&Tuner::processSamples, this,
+                                 ref(samples), first, last, t,
+                                 &threadGradients[t][0], &threadLosses[t]));
+    }
+
+    double loss = 0;
+    for (int t = 0; t < numThreads; t++)
+    {
+        threads[t].join();
+
+        loss += threadLosses[t];
+        for (int i = 0; i < TUNE_NUM_PARAMS; i++)
+            gradient[i] += threadGradients[t][i];
+    }
+
+    return loss;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Evaluates the samples in the range [first, last) in batches on the boards
+//of the thread specified. The gradient of the loss is added to the gradient
+//array and the total loss is written to loss.
+//////////////////////////////////////////////////////////////////////////////
+void Tuner :: processSamples(vector<TuneSample>& samples, unsigned int first,
+                             unsigned int last, int thread, double* gradient,
+                             double* loss)
+{
+    vector<Board>& boards = threadBoards[thread];
+    short scores[EVAL_BATCH_SIZE];
+    *loss = 0;
+
+    for (unsigned int batchFirst = first; batchFirst < last; 
+         batchFirst += EVAL_BATCH_SIZE)
+    {
+        unsigned int count = last - batchFirst;
+        if (count > EVAL_BATCH_SIZE)
+            count = EVAL_BATCH_SIZE;
+
+        //set up the boards with the samples' pieces, gold to move so the
+        //scores are in gold's perspective
+        for (unsigned int i = 0; i < count; i++)
+        {
+            for (int color = 0; color < MAX_COLORS; color++)
+                for (int type = 0; type < MAX_TYPES; type++)
+                    boards[i].pieces[color][type] =
+                               samples[batchFirst + i].pieces[color][type];
+
+            boards[i].sideToMove = GOLD;
+        }
+
+        eval.evalBatch(&boards[0], count, scores);
+
+        for (unsigned int i = 0; i < count; i++)
+        {
+            double score = scores[i];
+            double p = 1.0 / (1.0 + exp(-score / TUNE_SCORE_SCALE));
+            double y = samples[batchFirst + i].result;
+
+            //keep the probability away from 0 and 1 so the loss is finite
+            double pClamped = p;
+            if (pClamped < 1e-7)
+                pClamped = 1e-7;
+            if (pClamped > 1 - 1e-7)
+                pClamped = 1 - 1e-7;
+
+            *loss -= y * log(pClamped) + (1 - y) * log(1 - pClamped);
+
+            //The derivative of the loss in respect to the score, then each
+            //weight's derivative is that times how much it adds to the score
+            addFeatures(boards[i], (p - y) / TUNE_SCORE_SCALE, gradient);
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Reads games from the data file until a chunk's worth of samples are read
+//or the file ends. Every position after a move is a sample. Games without a
+//result are skipped. Returns the number of samples read.
+//////////////////////////////////////////////////////////////////////////////
+unsigned int Tuner :: readSamples(GameRecordReader& reader,
+                                  vector<TuneSample>& samples)
+{
+    samples.clear();
+
+    GameRecord game;
+    while (samples.size() < TUNE_CHUNK_SIZE && reader.nextGame(game))
+    {
+        if (game.winner == MAX_COLORS)
+            continue;
+
+        TuneSample sample;
+        sample.result = game.winner == GOLD ? 1 : 0;
+
+        game.setupBoard(readBoard);
+        for (unsigned int i = 0; i < game.moves.size(); i++)
+        {
+            readBoard.playCombo(game.moves[i]);
+            readBoard.changeTurn();
+
+            for (int color = 0; color < MAX_COLORS; color++)
+                for (int type = 0; type < MAX_TYPES; type++)
+                    sample.pieces[color][type] =
+                                        readBoard.pieces[color][type];
+
+            samples.push_back(sample);
+        }
+    }
+
+    return samples.size();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Adds the factor given to the gradient entry of each weight that adds to
+//the score of the board, and subtracts it from each weight that subtracts
+//from the score. This mirrors the terms of Eval :: evalBoard, which is
+//linear in its weights.
+//////////////////////////////////////////////////////////////////////////////
+void Tuner :: addFeatures(Board& board, double factor, double* gradient)
+{
+    for (int type = 0; type < MAX_TYPES; type++)
+    {
+        //material
+        int numGold   = numBits(board.pieces[GOLD][type]);
+        int numSilver = numBits(board.pieces[SILVER][type]);
+
+        if (numGold > 0)
+            gradient[TUNE_MATERIAL_PARAMS + type * 9 + numGold] += factor;
+        if (numSilver > 0)
+            gradient[TUNE_MATERIAL_PARAMS + type * 9 + numSilver] -= factor;
+
+        //positions, silver's weights are mirrored vertically from gold's
+        for (int color = 0; color < MAX_COLORS; color++)
+        {
+            Int64 b = board.pieces[color][type];
+            int pos;
+            while ((pos = bitScanForward(b)) != NO_BIT_FOUND)
+            {
+                b ^= Int64FromIndex(pos);
+
+                int row = pos / 8;
+                int col = pos % 8;
+                if (color == SILVER)
+                    row = 7 - row;
+                if (col > 3)
+                    col = 7 - col;
+
+                if (color == GOLD)
+                    gradient[TUNE_POS_PARAMS + type * 32 + row * 4 + col]
+                                                                += factor;
+                else
+                    gradient[TUNE_POS_PARAMS + type * 32 + row * 4 + col]
+                                                                -= factor;
+            }
+        }
+    }
+
+    //frozen pieces
+    Int64 strongGold = board.pieces[GOLD][ELEPHANT];
+    Int64 strongSilver = board.pieces[SILVER][ELEPHANT];
+
+    Int64 notNearGold   = ~near(board.getAllPiecesOfColor(GOLD));
+    Int64 notNearSilver = ~near(board.getAllPiecesOfColor(SILVER));
+
+    for (int type = CAMEL; type < MAX_TYPES; type++)
+    {
+        int numGold   = numBits(board.pieces[GOLD][type]
+                                & near(strongSilver) & notNearGold);
+        int numSilver = numBits(board.pieces[SILVER][type]
+                                & near(strongGold) & notNearSilver);
+
+        if (numGold > 0)
+            gradient[TUNE_FROZEN_PARAMS + (type - 1) * 9 + numGold] += factor;
+        if (numSilver > 0)
+            gradient[TUNE_FROZEN_PARAMS + (type - 1) * 9 + numSilver]
+                                                                 -= factor;
+
+        strongGold   |= board.pieces[GOLD][type];
+        strongSilver |= board.pieces[SILVER][type];
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Writes the current weights, rounded, onto the weight arrays of the eval
+//////////////////////////////////////////////////////////////////////////////
+void Tuner :: writeParamsToEval()
+{
+    for (int type = 0; type < MAX_TYPES; type++)
+    {
+        for (int num = 0; num < 9; num++)
+        {
+            eval.materialWeights[type][num] = (short)
+                   floor(params[TUNE_MATERIAL_PARAMS + type * 9 + num] + 0.5);
+        }
+
+        for (int row = 0; row < 8; row++)
+        {
+            for (int col = 0; col < 4; col++)
+            {
+                eval.setPosWeight(type, row, col, (short)
+                floor(params[TUNE_POS_PARAMS + type * 32 + row * 4 + col]
+                      + 0.5));
+            }
+        }
+    }
+
+    for (int type = 0; type < MAX_TYPES - 1; type++)
+    {
+        for (int num = 0; num < 9; num++)
+        {
+            eval.frozenWeights[type][num] = (short)
+                   floor(params[TUNE_FROZEN_PARAMS + type * 9 + num] + 0.5);
+        }
+    }
+}
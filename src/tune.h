@@ -0,0 +1,84 @@
+#ifndef __JR_TUNE_H__
+#define __JR_TUNE_H__
+
+//Tuning of the evaluation weights over positions taken from game records
+
+#include "board.h"
+#include "eval.h"
+#include "gamerecord.h"
+#include "int64.h"
+#include "piece.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+//number of tunable weights. There are 9 material weights for each type, 32
+//position weights for each type (only the left half of the board in gold's
+//perspective), and 9 frozen weights for each type but the elephant
+#define TUNE_MATERIAL_PARAMS 0
+#define TUNE_POS_PARAMS      (TUNE_MATERIAL_PARAMS + MAX_TYPES * 9)
+#define TUNE_FROZEN_PARAMS   (TUNE_POS_PARAMS + MAX_TYPES * 32)
+#define TUNE_NUM_PARAMS      (TUNE_FROZEN_PARAMS + (MAX_TYPES - 1) * 9)
+
+//number of samples read from the data file at once. The weights are updated
+//once per chunk, and only one chunk is kept in memory at a time
+#define TUNE_CHUNK_SIZE      (1 << 18)
+
+//scale of scores for the logistic function, that is a score of this
+//much in favor of a player means about a 73% chance of winning
+#define TUNE_SCORE_SCALE     400.0
+
+//default learning rate for the gradient descent
+#define TUNE_LEARNING_RATE   2000.0
+
+using namespace std;
+
+//A position to tune with, along with the result of the game it came from
+class TuneSample
+{
+    public:
+    Int64 pieces[MAX_COLORS][MAX_TYPES]; //bitboards of the position
+
+    float result; //1 if gold won the game, 0 if silver won
+};
+
+//Tunes the weights of an eval by gradient descent on the logistic loss of
+//the predicted outcomes of positions against the actual outcome of the games
+//they came from. The data file is a list of games in the format
+//GameRecordReader reads, and only games with a result are used. Positions
+//are replayed from the file in chunks, so the positions of the whole data
+//set don't need to fit in memory.
+class Tuner
+{
+    public:
+    Tuner(Eval& eval, int numThreads);
+
+    void tune(string dataFile, int numEpochs, double learningRate,
+              ostream& log);
+
+    double processChunk(vector<TuneSample>& samples, double* gradient);
+    void processSamples(vector<TuneSample>& samples, unsigned int first,
+                        unsigned int last, int thread, double* gradient,
+                        double* loss);
+
+    private:
+    unsigned int readSamples(GameRecordReader& reader,
+                             vector<TuneSample>& samples);
+    void addFeatures(Board& board, double factor, double* gradient);
+    void writeParamsToEval();
+
+    Eval& eval;        //the eval being tuned
+    int numThreads;    //number of threads to evaluate the samples with
+
+    double params[TUNE_NUM_PARAMS]; //current values of the weights. These
+                                    //are kept in full precision, and are
+                                    //rounded when written to an eval
+
+    //batches of boards each thread sets up samples on to evaluate
+    vector<vector<Board> > threadBoards;
+
+    //board the games read from the data file are replayed on
+    Board readBoard;
+};
+
+#endif